@@ -92,16 +92,15 @@ int main() {
     pin_set_pin_mode(PIN_RC0, true);
     pin_set_output(PIN_RC0, false);
     
+    uint32_t next_toggle = timer0_now(NULL) + 1000;
     while (1) {
-        // Check if 1 scond has expired. Disable intterupts during the 
-        // check-and-modify operation.
-        GIE = 0;
-        if (pic170x_timer0.ms > 1000) {
+        // Check if 1 second has expired. timer0_deadline_reached() reads
+        // the counter consistently, so interrupts can stay enabled.
+        if (timer0_deadline_reached(NULL, next_toggle)) {
             // If 1 second has expired, toggle the output signal on/off.
             pin_set_output(PIN_RC0, !pin_get_input(PIN_RC0));
-            pic170x_timer0.ms -= 1000;
+            next_toggle += 1000;
         }
-        GIE = 1;
         
         // .. here we can do some other things - timing will be done in 
         // the background
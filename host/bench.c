@@ -0,0 +1,409 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Host benchmark of the library API.
+ *
+ * Every benchmark calls one API function through a function pointer in a
+ * loop. Two costs are reported per call:
+ *
+ * - SFR accesses: loads and stores to the register model of
+ *   host/include/xc.h. The register page is protected while a benchmark
+ *   runs, every access faults, is counted and single-stepped with the page
+ *   unprotected. On the PIC each of these accesses is at least one
+ *   instruction plus bank selection, so the count is the part of the cost
+ *   that host code does not hide. Requires x86-64 Linux.
+ * - Host instructions: retired instructions through perf_event_open(), 
+ *   where hardware counters are available. The cost of an empty benchmark
+ *   function is subtracted. These are relative host numbers only, they
+ *   track code path length but not PIC cycles.
+ *
+ * Both counts are deterministic. Wall-clock time is not measured, it is too
+ * noisy for functions of a few instructions. The program fails if neither
+ * count is available.
+ */
+
+#define _GNU_SOURCE
+
+#include <xc.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "libpic170x/freq.h"
+#include "libpic170x/timer0.h"
+#include "libpic170x/io_control.h"
+#include "libpic170x/soft_timer.h"
+#include "libpic170x/ring_buffer.h"
+#include "libpic170x/debounce.h"
+#include "libpic170x/trace.h"
+#include "libpic170x/capture.h"
+#include "libpic170x/task.h"
+
+// Dispatcher with the timer0 entry only, see run_isr_timer0()
+#define LIBPIC170X_ISR_1 TIMER0_ISR_ENTRY
+#include "libpic170x/isr.h"
+
+#define ITERATIONS 100000
+// Every SFR access costs two signals, fewer iterations suffice
+#define SFR_ITERATIONS 256
+
+#if defined(__linux__) && defined(__x86_64__)
+  #define SFR_COUNTING 1
+  // Trap flag of EFLAGS, single-steps one instruction
+  #define EFLAGS_TF 0x100
+#else
+  #define SFR_COUNTING 0
+#endif
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+typedef struct {
+    const char* name;
+    void (*setup)(void);
+    void (*run)(void);
+} Benchmark;
+
+static volatile uint32_t sink;
+static int perf_fd = -1;
+
+static PinGroup group;
+static uint8_t group_values[PIN_GROUP_MAX_PORTS];
+static uint8_t ring_storage[16];
+static RingBuffer ring;
+
+static void nothing(void) {
+}
+
+static void run_pin_set_output(void) {
+    pin_set_output(PIN_RC0, true);
+}
+
+static void run_pin_get_input(void) {
+    sink = pin_get_input(PIN_RC0);
+}
+
+static void run_pin_set_pin_mode(void) {
+    pin_set_pin_mode(PIN_RC0, true);
+}
+
+static void run_pin_macro_set_output(void) {
+    PIN_SET_OUTPUT(RC0, true);
+}
+
+static void run_pin_id_set_output(void) {
+    pin_id_set_output(PIN_ID(RC0), true);
+}
+
+static void run_pin_id_get_input(void) {
+    sink = pin_id_get_input(PIN_ID(RC0));
+}
+
+static void setup_debounce(void) {
+    debounce_init();
+}
+
+static void run_debounce_tick(void) {
+    PORTA ^= 0x04;
+    debounce_tick();
+}
+
+static void setup_trace(void) {
+    timer0_init(NULL);
+    trace_init();
+}
+
+static void run_trace_event(void) {
+    trace_event(1);
+}
+
+static void setup_capture(void) {
+    capture_init(CAPTURE_PRESCALE_1);
+    capture_enable(CAPTURE_CHANNEL_CCP1, PIN_RC3, CAPTURE_MODE_PULSE);
+}
+
+static void run_capture_ih(void) {
+    CCPR1L += 100;
+    CCP1IF = 1;
+    capture_ih();
+}
+
+static uint8_t yielding_task(Task* task) {
+    TASK_BEGIN(task);
+    while (true) {
+        TASK_YIELD(task);
+    }
+    TASK_END(task);
+}
+
+static TaskSlot bench_tasks[] = { TASK_SLOT(yielding_task) };
+
+static void run_task_run(void) {
+    task_run(bench_tasks, 1);
+}
+
+static void setup_pin_group(void) {
+    const PinDef* pins[4];
+    
+    pins[0] = PIN_RC0;
+    pins[1] = PIN_RC1;
+    pins[2] = PIN_RC2;
+    pins[3] = PIN_RA2;
+    pin_group_init(&group, pins, 4);
+}
+
+static void run_pin_group_write(void) {
+    pin_group_write(&group, group_values);
+}
+
+static void setup_timer0(void) {
+    timer0_init(NULL);
+}
+
+static void run_timer0_ih(void) {
+    TMR0IF = 1;
+    timer0_ih(NULL);
+}
+
+static void run_isr_timer0(void) {
+    TMR0IF = 1;
+    libpic170x_isr();
+}
+
+static void run_timer0_now(void) {
+    sink = timer0_now(NULL);
+}
+
+static void run_timer0_now_us(void) {
+    sink = timer0_now_us(NULL);
+}
+
+static void setup_soft_timer(void) {
+    uint8_t i;
+    
+    soft_timer_init();
+    for (i = 0; i < LIBPIC170X_SOFT_TIMER_COUNT; i++) {
+        soft_timer_start(i, (uint16_t) (1 + 3 * i), (uint16_t) (5 + 7 * i), NULL);
+    }
+}
+
+static void run_soft_timer_tick(void) {
+    soft_timer_tick();
+    soft_timer_run();
+}
+
+static void setup_ring_buffer(void) {
+    ring_buffer_init(&ring, ring_storage, sizeof(ring_storage), 1);
+}
+
+static void run_ring_buffer_byte(void) {
+    uint8_t value;
+    
+    ring_buffer_push_byte(&ring, 0x55);
+    ring_buffer_pop_byte(&ring, &value);
+    sink = value;
+}
+
+static const Benchmark benchmarks[] = {
+    {"pin_set_output", NULL, run_pin_set_output},
+    {"pin_get_input", NULL, run_pin_get_input},
+    {"pin_set_pin_mode", NULL, run_pin_set_pin_mode},
+    {"PIN_SET_OUTPUT", NULL, run_pin_macro_set_output},
+    {"pin_id_set_output", NULL, run_pin_id_set_output},
+    {"pin_id_get_input", NULL, run_pin_id_get_input},
+    {"pin_group_write", setup_pin_group, run_pin_group_write},
+    {"timer0_ih", setup_timer0, run_timer0_ih},
+    {"isr dispatch timer0", setup_timer0, run_isr_timer0},
+    {"timer0_now", setup_timer0, run_timer0_now},
+    {"timer0_now_us", setup_timer0, run_timer0_now_us},
+    {"soft_timer_tick+run", setup_soft_timer, run_soft_timer_tick},
+    {"ring_buffer push+pop", setup_ring_buffer, run_ring_buffer_byte},
+    {"debounce_tick", setup_debounce, run_debounce_tick},
+    {"trace_event", setup_trace, run_trace_event},
+    {"capture_ih", setup_capture, run_capture_ih},
+    {"task_run yield", NULL, run_task_run},
+};
+
+#if SFR_COUNTING
+static volatile unsigned long sfr_accesses;
+
+static void protect_sfr(bool protect) {
+    mprotect((void*) __xc_mock_sfr, sizeof(__xc_mock_sfr), 
+        protect ? PROT_NONE : PROT_READ | PROT_WRITE);
+}
+
+// Counts the access, unprotects the page and steps over the instruction
+static void on_sfr_fault(int sig, siginfo_t* info, void* context) {
+    ucontext_t* uc = (ucontext_t*) context;
+    
+    if ((uintptr_t) info->si_addr - (uintptr_t) __xc_mock_sfr 
+            >= sizeof(__xc_mock_sfr)) {
+        // Not a register access, crash with the default action
+        signal(sig, SIG_DFL);
+        return;
+    }
+    sfr_accesses++;
+    protect_sfr(false);
+    uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+// Protects the page again after the access
+static void on_sfr_step(int sig, siginfo_t* info, void* context) {
+    ucontext_t* uc = (ucontext_t*) context;
+    
+    (void) sig;
+    (void) info;
+    protect_sfr(true);
+    uc->uc_mcontext.gregs[REG_EFL] &= ~(greg_t) EFLAGS_TF;
+}
+
+static bool open_sfr_counter(void) {
+    struct sigaction action;
+    
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = on_sfr_fault;
+    if (sigaction(SIGSEGV, &action, NULL) != 0) {
+        return false;
+    }
+    action.sa_sigaction = on_sfr_step;
+    return sigaction(SIGTRAP, &action, NULL) == 0;
+}
+
+static double measure_sfr(void (*run)(void)) {
+    long i;
+    
+    sfr_accesses = 0;
+    protect_sfr(true);
+    for (i = 0; i < SFR_ITERATIONS; i++) {
+        run();
+    }
+    protect_sfr(false);
+    return (double) sfr_accesses / SFR_ITERATIONS;
+}
+#else
+static bool open_sfr_counter(void) {
+    return false;
+}
+
+static double measure_sfr(void (*run)(void)) {
+    (void) run;
+    return 0.0;
+}
+#endif
+
+static void open_counter(void) {
+    struct perf_event_attr attr;
+    
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    perf_fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t read_counter(void) {
+    uint64_t value = 0;
+    
+    if (read(perf_fd, &value, sizeof(value)) != sizeof(value)) {
+        value = 0;
+    }
+    return value;
+}
+
+// Host instructions per call, perf_fd must be open
+static double measure(void (*run)(void)) {
+    uint64_t start, end;
+    long i;
+    
+    ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+    start = read_counter();
+    for (i = 0; i < ITERATIONS; i++) {
+        run();
+    }
+    end = read_counter();
+    ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+    return (double) (end - start) / ITERATIONS;
+}
+
+// Runs the setup of a benchmark on cleared registers
+static void setup(const Benchmark* benchmark) {
+    memset((void*) __xc_mock_sfr, 0, sizeof(__xc_mock_sfr));
+    if (benchmark->setup) {
+        benchmark->setup();
+    }
+}
+
+int main(void) {
+    size_t i;
+    bool sfr_counter;
+    double baseline = 0.0, sfr, cost;
+    
+    sfr_counter = open_sfr_counter();
+    open_counter();
+    if (!sfr_counter && (perf_fd < 0)) {
+        fprintf(stderr, "bench: neither SFR access counting (x86-64 Linux) "
+            "nor hardware instruction counters (perf_event_open) are "
+            "available\n");
+        return 1;
+    }
+    if (perf_fd >= 0) {
+        baseline = measure(nothing);
+    }
+    
+    printf("# chip=%s xtal_freq=%s timer0_period_us=%lu\n",
+        STR(LIBPIC170X_HOST_CHIP), STR(_XTAL_FREQ), 
+        (unsigned long) TIMER0_PERIOD_US);
+    printf("# per call: SFR accesses, host instructions (relative host "
+        "numbers, not PIC cycles)\n");
+    for (i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        printf("%-24s", benchmarks[i].name);
+        if (sfr_counter) {
+            setup(&benchmarks[i]);
+            sfr = measure_sfr(benchmarks[i].run);
+            printf(" %8.1f", sfr);
+        } else {
+            printf(" %8s", "-");
+        }
+        if (perf_fd >= 0) {
+            setup(&benchmarks[i]);
+            cost = measure(benchmarks[i].run) - baseline;
+            printf(" %8.1f", cost < 0 ? 0.0 : cost);
+        } else {
+            printf(" %8s", "-");
+        }
+        printf("\n");
+    }
+    
+    if (perf_fd >= 0) {
+        close(perf_fd);
+    }
+    return 0;
+}
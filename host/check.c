@@ -0,0 +1,713 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Host regression checks of the library API.
+ *
+ * Every check starts with cleared registers, calls the API and compares the
+ * results and the register model of host/include/xc.h with the expected
+ * values. Interrupts are simulated by setting the interrupt flag and calling
+ * the handler. The program prints one line per check and exits with a
+ * non-zero status if any comparison failed.
+ */
+
+#include <xc.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libpic170x/freq.h"
+#include "libpic170x/timer0.h"
+#include "libpic170x/clock.h"
+#include "libpic170x/soft_timer.h"
+#include "libpic170x/io_control.h"
+#include "libpic170x/ring_buffer.h"
+#include "libpic170x/i2c.h"
+#include "libpic170x/hef_store.h"
+#include "libpic170x/debounce.h"
+#include "libpic170x/task.h"
+
+#define LIBPIC170X_ISR_1 TIMER0_ISR_ENTRY
+#include "libpic170x/isr.h"
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+/**
+ * Compares two integer values, prints both and counts a failure if they
+ * differ.
+ */
+#define CHECK_EQUAL(actual, expected) \
+    check_equal((unsigned long) (actual), (unsigned long) (expected), \
+        #actual, __LINE__)
+
+#define CHECK(condition) CHECK_EQUAL((condition) != 0, 1)
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} Check;
+
+static unsigned failures;
+
+static void check_equal(unsigned long actual, unsigned long expected,
+        const char* expression, int line) {
+    if (actual != expected) {
+        printf("  line %d: %s is %lu, expected %lu\n",
+            line, expression, actual, expected);
+        failures++;
+    }
+}
+
+// Simulates a timer0 overflow that is handled by timer0_ih()
+static bool overflow(void) {
+    TMR0IF = 1;
+    return timer0_ih(NULL);
+}
+
+static void check_timer0_counter(void) {
+    uint32_t i, total_us;
+
+    timer0_init(NULL);
+    CHECK_EQUAL(OPTION_REG & 0x0F, TIMER0_PRESCALE_BITS);
+    CHECK_EQUAL(TMR0, TIMER0_PRELOAD);
+    CHECK(TMR0IE);
+    CHECK(!timer0_ih(NULL));
+    CHECK_EQUAL(pic170x_timer0.seq, 0);
+
+    // Long enough for every us increment to carry several times
+    for (i = 1; i <= 3000; i++) {
+        CHECK(overflow());
+        CHECK(!TMR0IF);
+        total_us = i * TIMER0_PERIOD_US;
+        CHECK_EQUAL(pic170x_timer0.ms, total_us / 1000);
+        CHECK_EQUAL(pic170x_timer0.us, total_us % 1000);
+        if (failures) {
+            break;
+        }
+    }
+    CHECK_EQUAL(pic170x_timer0.seq, (uint8_t) (i - 1));
+    CHECK_EQUAL(timer0_now(NULL), pic170x_timer0.ms);
+}
+
+static void check_timer0_isr_entry(void) {
+    uint32_t i, total_us;
+
+    timer0_init(NULL);
+    for (i = 1; i <= 3000; i++) {
+        TMR0IF = 1;
+        libpic170x_isr();
+        CHECK(!TMR0IF);
+        total_us = i * TIMER0_PERIOD_US;
+        CHECK_EQUAL(pic170x_timer0.ms, total_us / 1000);
+        CHECK_EQUAL(pic170x_timer0.us, total_us % 1000);
+        if (failures) {
+            break;
+        }
+    }
+}
+
+static void check_timer0_reload(void) {
+    uint8_t reload;
+
+    timer0_init(NULL);
+    // Increments that happened between the overflow and the update
+    TMR0 = 3;
+    overflow();
+    if (TIMER0_PRELOAD) {
+        // Exact mode: the preload is added and the two increments that are
+        // inhibited by the write are compensated, which is only possible
+        // without prescaler
+        CHECK_EQUAL(TIMER0_PRESCALE_BITS, 0x08);
+        reload = (uint8_t) (TIMER0_PRELOAD + 2);
+        CHECK_EQUAL(TMR0, (uint8_t) (3 + reload));
+        CHECK_EQUAL(TIMER0_PERIOD_US,
+            (uint32_t) (256 - TIMER0_PRELOAD) << TIMER0_TICK_US_SHIFT);
+    } else {
+        // Free-running: TMR0 is never written
+        CHECK_EQUAL(TMR0, 3);
+        CHECK_EQUAL(TIMER0_PERIOD_US, 256ul << TIMER0_TICK_US_SHIFT);
+    }
+}
+
+static void check_timer0_now_us(void) {
+    timer0_init(NULL);
+    overflow();
+    TMR0 = (uint8_t) (TIMER0_PRELOAD + 10);
+    CHECK_EQUAL(timer0_now_us(NULL),
+        TIMER0_PERIOD_US + (10ul << TIMER0_TICK_US_SHIFT));
+    // An overflow that was not handled yet counts as a full period
+    TMR0 = 5;
+    TMR0IF = 1;
+    CHECK_EQUAL(timer0_now_us(NULL),
+        2 * TIMER0_PERIOD_US + (5ul << TIMER0_TICK_US_SHIFT));
+}
+
+static uint8_t fired_count[LIBPIC170X_SOFT_TIMER_COUNT];
+static uint16_t fired_tick[LIBPIC170X_SOFT_TIMER_COUNT];
+static uint16_t current_tick;
+
+static void record_expiry(uint8_t timer) {
+    fired_count[timer]++;
+    fired_tick[timer] = current_tick;
+}
+
+static void run_ticks(uint16_t ticks) {
+    while (ticks--) {
+        current_tick++;
+        soft_timer_tick();
+        soft_timer_run();
+    }
+}
+
+static void check_soft_timer_wheel(void) {
+    uint8_t timer;
+    uint16_t delay;
+
+    soft_timer_init();
+    memset(fired_count, 0, sizeof(fired_count));
+    current_tick = 0;
+    CHECK_EQUAL(soft_timer_next_expiry(), SOFT_TIMER_NO_EXPIRY);
+
+    // One-shot timers with delays below and across several wheel
+    // revolutions expire exactly once, after their delay
+    for (timer = 0; timer < 4; timer++) {
+        delay = (uint16_t) (1 + timer * (LIBPIC170X_SOFT_TIMER_WHEEL_SIZE + 3));
+        CHECK(soft_timer_start(timer, delay, 0, record_expiry));
+    }
+    CHECK_EQUAL(soft_timer_next_expiry(), 1);
+    run_ticks(4 * LIBPIC170X_SOFT_TIMER_WHEEL_SIZE + 16);
+    for (timer = 0; timer < 4; timer++) {
+        CHECK_EQUAL(fired_count[timer], 1);
+        CHECK_EQUAL(fired_tick[timer], 1 + timer * (LIBPIC170X_SOFT_TIMER_WHEEL_SIZE + 3));
+        CHECK(!soft_timer_is_active(timer));
+    }
+    CHECK_EQUAL(soft_timer_next_expiry(), SOFT_TIMER_NO_EXPIRY);
+
+    // Periodic timer, delay 3 and period 5
+    memset(fired_count, 0, sizeof(fired_count));
+    current_tick = 0;
+    CHECK(soft_timer_start(0, 3, 5, record_expiry));
+    run_ticks(3);
+    CHECK_EQUAL(fired_count[0], 1);
+    CHECK_EQUAL(soft_timer_next_expiry(), 5);
+    run_ticks(100);
+    CHECK_EQUAL(fired_count[0], 1 + 100 / 5);
+    CHECK_EQUAL(fired_tick[0], 103);
+
+    // A stopped timer does not expire
+    soft_timer_stop(0);
+    run_ticks(10);
+    CHECK_EQUAL(fired_count[0], 1 + 100 / 5);
+    CHECK(!soft_timer_start(LIBPIC170X_SOFT_TIMER_COUNT, 1, 0, NULL));
+
+    // Skipped ticks flag an expiry once, the period continues afterwards
+    memset(fired_count, 0, sizeof(fired_count));
+    CHECK(soft_timer_start(1, 4, 10, record_expiry));
+    soft_timer_advance(25);
+    CHECK_EQUAL(soft_timer_next_expiry(), 0);
+    CHECK_EQUAL(soft_timer_run(), 1);
+    CHECK_EQUAL(fired_count[1], 1);
+    CHECK_EQUAL(soft_timer_next_expiry(), 10);
+}
+
+static void check_ring_buffer_wraparound(void) {
+    uint16_t storage[8];
+    uint16_t value, next_push = 0, next_pop = 0;
+    RingBuffer rb;
+    uint16_t round;
+    uint8_t i;
+
+    CHECK(!ring_buffer_init(&rb, storage, 6, sizeof(uint16_t)));
+    CHECK(ring_buffer_init(&rb, storage, 8, sizeof(uint16_t)));
+    CHECK_EQUAL(ring_buffer_count(&rb), 0);
+    CHECK_EQUAL(ring_buffer_space(&rb), 8);
+
+    // Uneven fill levels move the indices through several 8-bit wraps
+    for (round = 0; round < 300; round++) {
+        for (i = 0; i < (round % 8) + 1; i++) {
+            CHECK(ring_buffer_push(&rb, &next_push));
+            next_push++;
+        }
+        CHECK_EQUAL(ring_buffer_count(&rb), (round % 8) + 1);
+        while (ring_buffer_pop(&rb, &value)) {
+            CHECK_EQUAL(value, next_pop);
+            next_pop++;
+        }
+        if (failures) {
+            return;
+        }
+    }
+    CHECK_EQUAL(next_pop, next_push);
+
+    // Full and empty buffers across the wrap of the indices
+    for (i = 0; i < 8; i++) {
+        CHECK(ring_buffer_push(&rb, &next_push));
+        next_push++;
+    }
+    CHECK(!ring_buffer_push(&rb, &next_push));
+    CHECK_EQUAL(ring_buffer_space(&rb), 0);
+    CHECK_EQUAL(ring_buffer_pop_bulk(&rb, storage, 8), 8);
+    CHECK_EQUAL(ring_buffer_count(&rb), 0);
+    CHECK(!ring_buffer_pop(&rb, &value));
+}
+
+#ifdef LIBPIC170X_TIMER0_EXACT_PERIOD
+  #define EXACT_PERIOD true
+#else
+  #define EXACT_PERIOD false
+#endif
+
+static void check_clock_settings(void) {
+    static const Timer0Clock compiled = TIMER0_CLOCK_INIT;
+    Timer0Clock computed;
+
+    // The runtime derivation of clock.c must match the one of freq.h
+    memset(&computed, 0, sizeof(computed));
+    CHECK(clock_timer0_settings(&computed, CLOCK_XTAL_FREQ,
+        LIBPIC170X_TIMER0_PERIOD_US, EXACT_PERIOD));
+    CHECK_EQUAL(computed.period_us, compiled.period_us);
+    CHECK_EQUAL(computed.ms_inc, compiled.ms_inc);
+    CHECK_EQUAL(computed.us_inc, compiled.us_inc);
+    CHECK_EQUAL(computed.us_carry, compiled.us_carry);
+    CHECK_EQUAL(computed.prescale_bits, compiled.prescale_bits);
+    CHECK_EQUAL(computed.preload, compiled.preload);
+    CHECK_EQUAL(computed.reload, compiled.reload);
+    CHECK_EQUAL(computed.tick_us_shift, compiled.tick_us_shift);
+}
+
+static void check_clock_set(void) {
+    Timer0Clock expected, before;
+    uint8_t clock;
+    uint32_t ms, us;
+    bool keeps_period;
+
+    OSCCON = OSCCON_BITS;
+    // All oscillators report ready
+    OSCSTAT = 0xFF;
+    timer0_init(NULL);
+    CHECK_EQUAL(clock_get(), CLOCK_XTAL_FREQ);
+    CHECK(!clock_set(NULL, CLOCK_32MHZ + 1));
+
+    for (clock = CLOCK_500KHZ; clock <= CLOCK_32MHZ; clock++) {
+        before = pic170x_timer0_clock;
+        overflow();
+        ms = pic170x_timer0.ms;
+        us = pic170x_timer0.us;
+        TMR0 = (uint8_t) (before.preload + 20);
+
+        // The actual period is kept, not the target
+        keeps_period = clock_timer0_settings(&expected, clock,
+                TIMER0_PERIOD_US, EXACT_PERIOD)
+            && (expected.period_us == TIMER0_PERIOD_US)
+            && (expected.preload == TIMER0_PRELOAD);
+        if (!keeps_period) {
+            // Switches that change the period leave everything unchanged
+            CHECK(!clock_set(NULL, clock));
+            CHECK_EQUAL(TMR0, (uint8_t) (before.preload + 20));
+            CHECK_EQUAL(OPTION_REG & 0x0F, before.prescale_bits);
+            CHECK_EQUAL(pic170x_timer0.ms, ms);
+            CHECK_EQUAL(pic170x_timer0.us, us);
+            CHECK_EQUAL(pic170x_timer0_clock.period_us, TIMER0_PERIOD_US);
+            continue;
+        }
+        CHECK(clock_set(NULL, clock));
+        CHECK_EQUAL(clock_get(), clock);
+
+        // The elapsed part of the period is accounted with the old settings
+        us += 20ul << before.tick_us_shift;
+        CHECK_EQUAL(pic170x_timer0.ms, ms + us / 1000);
+        CHECK_EQUAL(pic170x_timer0.us, us % 1000);
+
+        // A new period of the same length starts with the new prescaler
+        CHECK_EQUAL(OPTION_REG & 0x0F, expected.prescale_bits);
+        CHECK_EQUAL(TMR0, expected.preload);
+        CHECK(!TMR0IF);
+        CHECK_EQUAL(pic170x_timer0_clock.period_us, TIMER0_PERIOD_US);
+        us = pic170x_timer0.us + TIMER0_PERIOD_US;
+        ms = pic170x_timer0.ms;
+        overflow();
+        CHECK_EQUAL(pic170x_timer0.ms, ms + us / 1000);
+        CHECK_EQUAL(pic170x_timer0.us, us % 1000);
+    }
+}
+
+// Simulates the completion of the operation that the MSSP was started with
+static void ssp_event(void) {
+    SSP1IF = 1;
+    i2c_ih();
+}
+
+static void check_i2c_timeout(void) {
+    static const uint8_t data[2] = {0x12, 0x34};
+    I2cTransaction transaction;
+    uint32_t ticks, i;
+
+    // Periods after which the counted time exceeds the timeout by a period
+    ticks = (LIBPIC170X_I2C_TIMEOUT_MS * 1000ul + TIMER0_PERIOD_US - 1)
+        / TIMER0_PERIOD_US + 1;
+
+    timer0_init(NULL);
+    i2c_init(I2C_CLOCK_CONFIG(100000), NULL, NULL);
+    memset(&transaction, 0, sizeof(transaction));
+    transaction.address = 0x40;
+    transaction.write_data = data;
+    transaction.write_length = sizeof(data);
+    CHECK(i2c_submit(&transaction));
+    CHECK(SSP1CON2bits.SEN);
+
+    // A timer0 tick between two events of a healthy transaction
+    ssp_event();
+    CHECK_EQUAL(SSP1BUF, 0x40 << 1);
+    overflow();
+    i2c_poll();
+    CHECK_EQUAL(transaction.status, I2C_STATUS_PENDING);
+    ssp_event();
+    CHECK_EQUAL(SSP1BUF, 0x12);
+
+    // A stalled bus is aborted once the counted time exceeds the timeout
+    // by one period
+    for (i = 1; i < ticks; i++) {
+        overflow();
+        i2c_poll();
+    }
+    CHECK_EQUAL(transaction.status, I2C_STATUS_PENDING);
+    overflow();
+    i2c_poll();
+    CHECK_EQUAL(transaction.status, I2C_STATUS_TIMEOUT);
+    CHECK(!i2c_busy());
+}
+
+static void check_pin_id_validity(void) {
+#if defined(PIC16F1709) || defined(PIC16LF1709)
+    static const uint8_t implemented[3] = {0x3F, 0xF0, 0xFF};
+#else
+    static const uint8_t implemented[3] = {0x3F, 0x00, 0x3F};
+#endif
+    PinId ids[3] = {PIN_ID(RA2), 0x0E, PIN_ID_NONE};
+    PinGroup group;
+    uint16_t id, address;
+    uint8_t port, expected;
+
+    // Only the registers of implemented pins are written
+    for (id = 0; id <= 0xFF; id++) {
+        pin_id_set_output((PinId) id, true);
+        pin_id_set_pin_mode((PinId) id, false);
+        pin_id_set_input_mode((PinId) id, PIN_INPUT_MODE_ANALOG);
+    }
+    for (address = 0; address < sizeof(__xc_mock_sfr); address++) {
+        expected = 0;
+        for (port = 0; port < 3; port++) {
+            if ((address == (uint16_t) (&LATA - __xc_mock_sfr) + port)
+                    || (address == (uint16_t) (&TRISA - __xc_mock_sfr) + port)
+                    || (address == (uint16_t) (&ANSELA - __xc_mock_sfr) + port)) {
+                expected = implemented[port];
+            }
+        }
+        CHECK_EQUAL(__xc_mock_sfr[address], expected);
+    }
+    PORTB = 0xFF;
+    CHECK_EQUAL(pin_id_get_input(0x0E), (implemented[1] & 0x40) != 0);
+    CHECK(!pin_id_get_input(PIN_ID_NONE));
+
+    // RB6 only exists on the PIC16(L)F1709
+    pin_group_init_ids(&group, ids, 3);
+    CHECK_EQUAL(group.port_count, implemented[1] ? 2 : 1);
+}
+
+// Takes the given number of samples of the current port levels
+static void debounce_samples(uint8_t samples) {
+    while (samples--) {
+        debounce_tick();
+    }
+}
+
+static void check_debounce(void) {
+    PORTA = 0x00;
+    PORTC = PIN_MASK(RC1);
+    debounce_init();
+    CHECK_EQUAL(debounce_state(DEBOUNCE_PORT_A), 0x00);
+    CHECK_EQUAL(debounce_state(DEBOUNCE_PORT_C), PIN_MASK(RC1));
+    CHECK(!debounce_get(PIN_ID_NONE));
+
+    // A change is taken after exactly DEBOUNCE_SAMPLES differing samples
+    PORTA = PIN_MASK(RA2);
+    debounce_samples(DEBOUNCE_SAMPLES - 1);
+    CHECK(!debounce_get(PIN_ID(RA2)));
+    CHECK_EQUAL(debounce_rising(DEBOUNCE_PORT_A, 0xFF), 0);
+    debounce_samples(1);
+    CHECK(debounce_get(PIN_ID(RA2)));
+    CHECK_EQUAL(debounce_rising(DEBOUNCE_PORT_A, 0xFF), PIN_MASK(RA2));
+    CHECK_EQUAL(debounce_rising(DEBOUNCE_PORT_A, 0xFF), 0);
+    CHECK_EQUAL(debounce_falling(DEBOUNCE_PORT_A, 0xFF), 0);
+
+    // A single bouncing sample restarts the count
+    PORTA = 0x00;
+    debounce_samples(DEBOUNCE_SAMPLES - 1);
+    PORTA = PIN_MASK(RA2);
+    debounce_samples(1);
+    PORTA = 0x00;
+    debounce_samples(DEBOUNCE_SAMPLES - 1);
+    CHECK(debounce_get(PIN_ID(RA2)));
+    CHECK_EQUAL(debounce_falling(DEBOUNCE_PORT_A, 0xFF), 0);
+    debounce_samples(1);
+    CHECK(!debounce_get(PIN_ID(RA2)));
+    CHECK_EQUAL(debounce_falling(DEBOUNCE_PORT_A, PIN_MASK(RA4)), 0);
+    CHECK_EQUAL(debounce_falling(DEBOUNCE_PORT_A, 0xFF), PIN_MASK(RA2));
+
+    // Pins of a port are counted independently
+    PORTC = PIN_MASK(RC0);
+    debounce_samples(2);
+    PORTC = 0x00;
+    debounce_samples(DEBOUNCE_SAMPLES - 2);
+    CHECK_EQUAL(debounce_state(DEBOUNCE_PORT_C), 0x00);
+    CHECK_EQUAL(debounce_falling(DEBOUNCE_PORT_C, 0xFF), PIN_MASK(RC1));
+    CHECK_EQUAL(debounce_rising(DEBOUNCE_PORT_C, 0xFF), 0);
+    CHECK_EQUAL(debounce_state(3), 0);
+}
+
+#define TASK_SLEEP 100
+
+static uint8_t sleeper_runs, sleeper_ends;
+
+// Sleeps once and ends
+static uint8_t sleeper(Task* task) {
+    sleeper_runs++;
+    TASK_BEGIN(task);
+    TASK_SLEEP_MS(task, TASK_SLEEP);
+    sleeper_ends++;
+    TASK_END(task);
+}
+
+static uint8_t quitter_runs;
+
+// Ends with its first call
+static uint8_t quitter(Task* task) {
+    quitter_runs++;
+    TASK_BEGIN(task);
+    TASK_EXIT(task);
+    TASK_END(task);
+}
+
+static void check_task(void) {
+    TaskSlot tasks[] = { TASK_SLOT(sleeper), TASK_SLOT(quitter) };
+    Task task = TASK_INIT;
+    uint32_t start;
+    uint8_t i;
+
+    // The deadline of TASK_SLEEP_MS() lies behind a wraparound of the ms
+    // counter
+    timer0_init(NULL);
+    pic170x_timer0.ms = 0xFFFFFFFFul - TASK_SLEEP / 2;
+    start = pic170x_timer0.ms;
+    sleeper_runs = 0;
+    sleeper_ends = 0;
+    CHECK_EQUAL(sleeper(&task), TASK_WAITING);
+    while (pic170x_timer0.ms - start < TASK_SLEEP) {
+        CHECK_EQUAL(sleeper(&task), TASK_WAITING);
+        overflow();
+    }
+    CHECK(pic170x_timer0.ms < start);
+    CHECK_EQUAL(sleeper(&task), TASK_DONE);
+    CHECK_EQUAL(sleeper_ends, 1);
+    CHECK(task_is_done(&task));
+
+    // A finished task does not run its body again
+    for (i = 0; i < 3; i++) {
+        CHECK_EQUAL(sleeper(&task), TASK_DONE);
+    }
+    CHECK_EQUAL(sleeper_ends, 1);
+    task_restart(&task);
+    CHECK(!task_is_done(&task));
+    CHECK_EQUAL(sleeper(&task), TASK_WAITING);
+
+    // task_run() calls finished tasks no more
+    start = pic170x_timer0.ms;
+    sleeper_runs = 0;
+    quitter_runs = 0;
+    CHECK_EQUAL(task_run(tasks, 2), 1);
+    CHECK(task_is_done(&tasks[1].task));
+    for (i = 0; i < 3; i++) {
+        CHECK_EQUAL(task_run(tasks, 2), 1);
+    }
+    CHECK_EQUAL(quitter_runs, 1);
+    CHECK_EQUAL(sleeper_runs, 4);
+    while (pic170x_timer0.ms - start < TASK_SLEEP) {
+        overflow();
+    }
+    CHECK_EQUAL(task_run(tasks, 2), 0);
+    CHECK_EQUAL(task_run(tasks, 2), 0);
+    CHECK_EQUAL(sleeper_runs, 5);
+    CHECK_EQUAL(quitter_runs, 1);
+}
+
+// HEF row of the log, as modelled program memory words
+static uint16_t* hef_row(uint8_t row) {
+    return &__xc_mock_flash[HEF_STORE_ADDRESS + row * HEF_STORE_ROW_SIZE];
+}
+
+// Commits a new value and simulates a restart that loads it again
+static bool hef_commit_value(uint16_t value) {
+    uint16_t loaded = 0;
+
+    CHECK(hef_store_write(0, &value, sizeof(value)));
+    CHECK(hef_store_dirty());
+    if (!hef_store_commit()) {
+        return false;
+    }
+    CHECK(!hef_store_dirty());
+    CHECK(hef_store_init());
+    CHECK(hef_store_read(0, &loaded, sizeof(loaded)));
+    CHECK_EQUAL(loaded, value);
+    return true;
+}
+
+static void check_hef_store_log(void) {
+    uint8_t byte = 0;
+    uint16_t i;
+
+    __xc_mock_flash_reset();
+    CHECK(!hef_store_init());
+    CHECK(hef_store_read(HEF_STORE_SIZE - 1, &byte, 1));
+    CHECK_EQUAL(byte, 0xFF);
+    CHECK(!hef_store_read(HEF_STORE_SIZE - 1, &byte, 2));
+    CHECK(!hef_store_write(HEF_STORE_SIZE, &byte, 1));
+    // Writing the stored value does not make the store dirty
+    CHECK(hef_store_write(0, &byte, 1));
+    CHECK(!hef_store_dirty());
+    CHECK(hef_store_commit());
+
+    // Commit i has sequence number i in row i % 4, so the 8-bit sequence
+    // numbers wrap from 255 to 0 across rows several times
+    for (i = 0; i < 600; i++) {
+        CHECK(hef_commit_value(i));
+        CHECK_EQUAL((uint8_t) hef_row(i % HEF_STORE_ROWS)[0], i & 0xFF);
+        // The upper bits of the words are not written
+        CHECK_EQUAL(hef_row(i % HEF_STORE_ROWS)[1] >> 8, 0x3F);
+        if (failures) {
+            return;
+        }
+    }
+}
+
+static void check_hef_store_torn_row(void) {
+    uint16_t value = 0;
+    uint8_t i;
+
+    __xc_mock_flash_reset();
+    hef_store_init();
+    for (i = 0; i < 6; i++) {
+        CHECK(hef_commit_value(i));
+    }
+
+    // Power failure after the erase of the next row: row 1 holds 5, row 2
+    // was the oldest row with 2 and is erased
+    hef_store_write(0, &value, sizeof(value));
+    CHECK(hef_store_commit());
+    for (i = 0; i < HEF_STORE_ROW_SIZE; i++) {
+        hef_row(2)[i] = 0x3FFF;
+    }
+    CHECK(hef_store_init());
+    hef_store_read(0, &value, sizeof(value));
+    CHECK_EQUAL(value, 5);
+
+    // Power failure during the write: a record byte of the new row lacks
+    // bits, the checksum does not match
+    value = 0x1234;
+    hef_store_write(0, &value, sizeof(value));
+    CHECK(hef_store_commit());
+    hef_row(2)[1] &= 0x3F00 | 0x30;
+    CHECK(hef_store_init());
+    hef_store_read(0, &value, sizeof(value));
+    CHECK_EQUAL(value, 5);
+
+    // The log continues in the torn row, with the sequence number that
+    // follows the loaded row, without touching the valid ones
+    CHECK(hef_commit_value(7));
+    CHECK_EQUAL((uint8_t) hef_row(2)[0], 6);
+    CHECK_EQUAL((uint8_t) hef_row(1)[0], 5);
+}
+
+static void check_hef_store_worn_row(void) {
+    uint16_t value = 0;
+    uint8_t row;
+
+    __xc_mock_flash_reset();
+    hef_store_init();
+    CHECK(hef_commit_value(1));
+    CHECK(hef_commit_value(2));
+
+    // Row 2 does not verify, the commit is erased there and moves on
+    __xc_mock_flash_worn[HEF_STORE_ADDRESS / __XC_MOCK_FLASH_ROW_WORDS + 2] = 1;
+    CHECK(hef_commit_value(3));
+    CHECK_EQUAL(hef_row(2)[0], 0x3FFF);
+    CHECK_EQUAL((uint8_t) hef_row(3)[0], 2);
+    CHECK(hef_commit_value(4));
+    CHECK_EQUAL((uint8_t) hef_row(0)[0], 3);
+
+    // No row can be written: the commit fails, the committed state and the
+    // uncommitted write are kept
+    for (row = 0; row < HEF_STORE_ROWS; row++) {
+        __xc_mock_flash_worn[HEF_STORE_ADDRESS / __XC_MOCK_FLASH_ROW_WORDS + row] = 1;
+    }
+    value = 5;
+    hef_store_write(0, &value, sizeof(value));
+    CHECK(!hef_store_commit());
+    CHECK(hef_store_dirty());
+    hef_store_read(0, &value, sizeof(value));
+    CHECK_EQUAL(value, 5);
+    CHECK(hef_store_init());
+    hef_store_read(0, &value, sizeof(value));
+    CHECK_EQUAL(value, 4);
+}
+
+static const Check checks[] = {
+    {"timer0 counter", check_timer0_counter},
+    {"timer0 isr entry", check_timer0_isr_entry},
+    {"timer0 reload", check_timer0_reload},
+    {"timer0_now_us", check_timer0_now_us},
+    {"soft_timer wheel", check_soft_timer_wheel},
+    {"ring_buffer wraparound", check_ring_buffer_wraparound},
+    {"clock_timer0_settings", check_clock_settings},
+    {"clock_set", check_clock_set},
+    {"i2c timeout", check_i2c_timeout},
+    {"pin_id validity", check_pin_id_validity},
+    {"debounce", check_debounce},
+    {"task", check_task},
+    {"hef_store log", check_hef_store_log},
+    {"hef_store torn row", check_hef_store_torn_row},
+    {"hef_store worn row", check_hef_store_worn_row},
+};
+
+int main(void) {
+    size_t i;
+    unsigned failed = 0;
+
+    printf("# chip=%s xtal_freq=%s timer0_period_us=%lu%s\n",
+        STR(LIBPIC170X_HOST_CHIP), STR(_XTAL_FREQ),
+        (unsigned long) TIMER0_PERIOD_US, TIMER0_PRELOAD ? " exact" : "");
+    for (i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        memset((void*) __xc_mock_sfr, 0, sizeof(__xc_mock_sfr));
+        failures = 0;
+        checks[i].run();
+        printf("%-24s %s\n", checks[i].name, failures ? "FAILED" : "ok");
+        if (failures) {
+            failed++;
+        }
+    }
+    return failed ? 1 : 0;
+}
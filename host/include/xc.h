@@ -0,0 +1,216 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Host replacement for the xc.h header of XC8.
+ *
+ * Models the special function registers used by libpic170x as plain memory,
+ * so that the library can be compiled and exercised with gcc on a host
+ * machine (see the host and bench targets of the Makefile). Registers live in
+ * __xc_mock_sfr at their data memory addresses of the PIC16(L)F1705/1709,
+ * which keeps register arithmetic like (&PORTA)[index] working. Hardware
+ * side effects (flags set by peripherals, reads that clear flags) are not
+ * modelled, except for the program memory: a read or write that PMCON1
+ * starts is carried out by the next NOP(), see host/xc_mock.c.
+ */
+
+#ifndef LIBPIC170X_HOST_XC_H
+#define LIBPIC170X_HOST_XC_H
+
+#include <stdint.h>
+
+extern volatile unsigned char __xc_mock_sfr[0x1000];
+
+// Program memory words, erased words are 0x3FFF
+#define __XC_MOCK_FLASH_WORDS 0x2000
+#define __XC_MOCK_FLASH_ROW_WORDS 32
+extern uint16_t __xc_mock_flash[__XC_MOCK_FLASH_WORDS];
+// Rows that ignore writes, e.g. worn out rows, indexed by address / 32
+extern uint8_t __xc_mock_flash_worn[__XC_MOCK_FLASH_WORDS / __XC_MOCK_FLASH_ROW_WORDS];
+
+// Erases the program memory model and clears the write latches
+void __xc_mock_flash_reset(void);
+// Completes the program memory operation started through PMCON1
+void __xc_mock_nop(void);
+
+typedef struct {
+    unsigned char b0:1, b1:1, b2:1, b3:1, b4:1, b5:1, b6:1, b7:1;
+} __xc_mock_bits_t;
+
+#define __XC_SFR(address) (__xc_mock_sfr[(address)])
+#define __XC_BIT(address, n) (((volatile __xc_mock_bits_t*) &__xc_mock_sfr[(address)])->b##n)
+#define __XC_BITS(address, ...) \
+    (*(volatile struct { unsigned char __VA_ARGS__; } *) &__xc_mock_sfr[(address)])
+
+#define interrupt
+#define NOP() __xc_mock_nop()
+#define SLEEP() ((void) 0)
+#define CLRWDT() ((void) 0)
+
+// Registers
+#define STATUS       __XC_SFR(0x003)
+#define INTCON       __XC_SFR(0x00B)
+#define PORTA        __XC_SFR(0x00C)
+#define PORTB        __XC_SFR(0x00D)
+#define PORTC        __XC_SFR(0x00E)
+#define PIR1         __XC_SFR(0x011)
+#define PIR2         __XC_SFR(0x012)
+#define TMR0         __XC_SFR(0x015)
+#define TMR1L        __XC_SFR(0x016)
+#define TMR1H        __XC_SFR(0x017)
+#define T1CON        __XC_SFR(0x018)
+#define TMR2         __XC_SFR(0x01A)
+#define PR2          __XC_SFR(0x01B)
+#define T2CON        __XC_SFR(0x01C)
+#define TRISA        __XC_SFR(0x08C)
+#define TRISB        __XC_SFR(0x08D)
+#define TRISC        __XC_SFR(0x08E)
+#define PIE1         __XC_SFR(0x091)
+#define PIE2         __XC_SFR(0x092)
+#define OPTION_REG   __XC_SFR(0x095)
+#define WDTCON       __XC_SFR(0x097)
+#define OSCCON       __XC_SFR(0x099)
+#define OSCSTAT      __XC_SFR(0x09A)
+#define ADRESL       __XC_SFR(0x09B)
+#define ADRESH       __XC_SFR(0x09C)
+#define ADCON0       __XC_SFR(0x09D)
+#define ADCON1       __XC_SFR(0x09E)
+#define ADCON2       __XC_SFR(0x09F)
+#define LATA         __XC_SFR(0x10C)
+#define LATB         __XC_SFR(0x10D)
+#define LATC         __XC_SFR(0x10E)
+#define ANSELA       __XC_SFR(0x18C)
+#define ANSELB       __XC_SFR(0x18D)
+#define ANSELC       __XC_SFR(0x18E)
+#define PMADRL       __XC_SFR(0x191)
+#define PMADRH       __XC_SFR(0x192)
+#define PMDATL       __XC_SFR(0x193)
+#define PMDATH       __XC_SFR(0x194)
+#define PMCON1       __XC_SFR(0x195)
+#define PMCON2       __XC_SFR(0x196)
+#define RC1REG       __XC_SFR(0x199)
+#define TX1REG       __XC_SFR(0x19A)
+#define SP1BRGL      __XC_SFR(0x19B)
+#define SP1BRGH      __XC_SFR(0x19C)
+#define RC1STA       __XC_SFR(0x19D)
+#define TX1STA       __XC_SFR(0x19E)
+#define BAUD1CON     __XC_SFR(0x19F)
+#define SSP1BUF      __XC_SFR(0x211)
+#define SSP1ADD      __XC_SFR(0x212)
+#define SSP1MSK      __XC_SFR(0x213)
+#define SSP1STAT     __XC_SFR(0x214)
+#define SSP1CON1     __XC_SFR(0x215)
+#define SSP1CON2     __XC_SFR(0x216)
+#define SSP1CON3     __XC_SFR(0x217)
+#define CCPR1L       __XC_SFR(0x291)
+#define CCPR1H       __XC_SFR(0x292)
+#define CCP1CON      __XC_SFR(0x293)
+#define CCPR2L       __XC_SFR(0x298)
+#define CCPR2H       __XC_SFR(0x299)
+#define CCP2CON      __XC_SFR(0x29A)
+#define IOCAP        __XC_SFR(0x391)
+#define IOCAN        __XC_SFR(0x392)
+#define IOCAF        __XC_SFR(0x393)
+#define IOCBP        __XC_SFR(0x394)
+#define IOCBN        __XC_SFR(0x395)
+#define IOCBF        __XC_SFR(0x396)
+#define IOCCP        __XC_SFR(0x397)
+#define IOCCN        __XC_SFR(0x398)
+#define IOCCF        __XC_SFR(0x399)
+#define PWM3DCL      __XC_SFR(0x617)
+#define PWM3DCH      __XC_SFR(0x618)
+#define PWM3CON      __XC_SFR(0x619)
+#define PWM4DCL      __XC_SFR(0x61A)
+#define PWM4DCH      __XC_SFR(0x61B)
+#define PWM4CON      __XC_SFR(0x61C)
+#define PPSLOCK      __XC_SFR(0xE0F)
+#define INTPPS       __XC_SFR(0xE10)
+#define T0CKIPPS     __XC_SFR(0xE11)
+#define T1CKIPPS     __XC_SFR(0xE12)
+#define CCP1PPS      __XC_SFR(0xE14)
+#define CCP2PPS      __XC_SFR(0xE15)
+#define SSPCLKPPS    __XC_SFR(0xE20)
+#define SSPDATPPS    __XC_SFR(0xE21)
+#define SSPSSPPS     __XC_SFR(0xE22)
+#define RXPPS        __XC_SFR(0xE24)
+#define CKPPS        __XC_SFR(0xE25)
+#define RA0PPS       __XC_SFR(0xE90)
+#define RA1PPS       __XC_SFR(0xE91)
+#define RA2PPS       __XC_SFR(0xE92)
+#define RA4PPS       __XC_SFR(0xE94)
+#define RA5PPS       __XC_SFR(0xE95)
+#define RB4PPS       __XC_SFR(0xE9C)
+#define RB5PPS       __XC_SFR(0xE9D)
+#define RB6PPS       __XC_SFR(0xE9E)
+#define RB7PPS       __XC_SFR(0xE9F)
+#define RC0PPS       __XC_SFR(0xEA0)
+#define RC1PPS       __XC_SFR(0xEA1)
+#define RC2PPS       __XC_SFR(0xEA2)
+#define RC3PPS       __XC_SFR(0xEA3)
+#define RC4PPS       __XC_SFR(0xEA4)
+#define RC5PPS       __XC_SFR(0xEA5)
+#define RC6PPS       __XC_SFR(0xEA6)
+#define RC7PPS       __XC_SFR(0xEA7)
+
+// Bits
+#define nTO          __XC_BIT(0x003, 4)
+#define nPD          __XC_BIT(0x003, 3)
+#define GIE          __XC_BIT(0x00B, 7)
+#define PEIE         __XC_BIT(0x00B, 6)
+#define TMR0IE       __XC_BIT(0x00B, 5)
+#define IOCIE        __XC_BIT(0x00B, 3)
+#define TMR0IF       __XC_BIT(0x00B, 2)
+#define IOCIF        __XC_BIT(0x00B, 0)
+#define ADIF         __XC_BIT(0x011, 6)
+#define RCIF         __XC_BIT(0x011, 5)
+#define TXIF         __XC_BIT(0x011, 4)
+#define SSP1IF       __XC_BIT(0x011, 3)
+#define CCP1IF       __XC_BIT(0x011, 2)
+#define TMR2IF       __XC_BIT(0x011, 1)
+#define TMR1IF       __XC_BIT(0x011, 0)
+#define BCL1IF       __XC_BIT(0x012, 3)
+#define CCP2IF       __XC_BIT(0x012, 0)
+#define ADIE         __XC_BIT(0x091, 6)
+#define RCIE         __XC_BIT(0x091, 5)
+#define TXIE         __XC_BIT(0x091, 4)
+#define SSP1IE       __XC_BIT(0x091, 3)
+#define CCP1IE       __XC_BIT(0x091, 2)
+#define TMR2IE       __XC_BIT(0x091, 1)
+#define TMR1IE       __XC_BIT(0x091, 0)
+#define BCL1IE       __XC_BIT(0x092, 3)
+#define CCP2IE       __XC_BIT(0x092, 0)
+#define TMR0CS       __XC_BIT(0x095, 5)
+#define SWDTEN       __XC_BIT(0x097, 0)
+
+// Bit field structures
+#define OSCSTATbits __XC_BITS(0x09A, \
+    HFIOFS:1, LFIOFR:1, MFIOFR:1, HFIOFL:1, HFIOFR:1, OSTS:1, PLLR:1, SOSCR:1)
+#define PMCON1bits __XC_BITS(0x195, \
+    RD:1, WR:1, WREN:1, WRERR:1, FREE:1, LWLO:1, CFGS:1, :1)
+#define RC1STAbits __XC_BITS(0x19D, \
+    RX9D:1, OERR:1, FERR:1, ADDEN:1, CREN:1, SREN:1, RX9:1, SPEN:1)
+#define TX1STAbits __XC_BITS(0x19E, \
+    TX9D:1, TRMT:1, BRGH:1, SENDB:1, SYNC:1, TXEN:1, TX9:1, CSRC:1)
+#define BAUD1CONbits __XC_BITS(0x19F, \
+    ABDEN:1, WUE:1, :1, BRG16:1, SCKP:1, :1, RCIDL:1, ABDOVF:1)
+#define SSP1STATbits __XC_BITS(0x214, \
+    BF:1, UA:1, R_nW:1, S:1, P:1, D_nA:1, CKE:1, SMP:1)
+#define SSP1CON1bits __XC_BITS(0x215, \
+    SSPM:4, CKP:1, SSPEN:1, SSPOV:1, WCOL:1)
+#define SSP1CON2bits __XC_BITS(0x216, \
+    SEN:1, RSEN:1, PEN:1, RCEN:1, ACKEN:1, ACKDT:1, ACKSTAT:1, GCEN:1)
+
+#endif /* LIBPIC170X_HOST_XC_H */
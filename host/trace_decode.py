@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+#
+#   Copyright 2018 Paul Konstantin Gerke
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+
+"""Decodes trace_dump() output (see libpic170x/trace.h).
+
+Reads one or more dumps from a file, a serial device that was configured
+with stty, or stdin, and prints the events and latency histograms.
+
+Examples:
+
+    trace_decode.py --list dump.bin
+    trace_decode.py --name 1=rx_start --name 2=rx_end --pair 1:2 /dev/ttyUSB0
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"TR"
+FORMAT_VERSION = 1
+HEADER = struct.Struct("<BBHIBB")
+RECORD = struct.Struct("<BBHH")
+PENDING = 0x80
+
+
+class Dump:
+    def __init__(self, lost, period_us, preload, tick_us_shift, events):
+        self.lost = lost
+        self.period_us = period_us
+        self.preload = preload
+        self.tick_us_shift = tick_us_shift
+        # List of (time in us, event id)
+        self.events = events
+
+
+def record_time(dump, ms, us, tmr0, pending):
+    if pending:
+        # TMR0 counts from 0 since the overflow that was not processed yet
+        ticks = tmr0
+        us += dump.period_us
+    else:
+        ticks = (tmr0 - dump.preload) & 0xFF
+    return ms * 1000 + us + (ticks << dump.tick_us_shift)
+
+
+def parse_dumps(data):
+    """Yields all dumps in data, skipping garbage and corrupted dumps."""
+    pos = 0
+    while True:
+        pos = data.find(MAGIC, pos)
+        if pos < 0:
+            return
+        start = pos + len(MAGIC)
+        if start + HEADER.size > len(data):
+            return
+        version, count, lost, period_us, preload, shift = \
+            HEADER.unpack_from(data, start)
+        end = start + HEADER.size + count * RECORD.size
+        if version != FORMAT_VERSION or end >= len(data) \
+                or sum(data[start:end]) & 0xFF != data[end]:
+            print("warning: skipping corrupted dump at offset %d" % pos,
+                  file=sys.stderr)
+            pos += 1
+            continue
+
+        dump = Dump(lost, period_us, preload, shift, [])
+        ms_base = 0
+        previous_ms = None
+        for offset in range(start + HEADER.size, end, RECORD.size):
+            event_id, tmr0, ms, us = RECORD.unpack_from(data, offset)
+            # Only the lower 16 bits of the ms counter are recorded, events
+            # must not be more than 65 s apart
+            if previous_ms is not None and ms < previous_ms:
+                ms_base += 0x10000
+            previous_ms = ms
+            dump.events.append((
+                record_time(dump, ms_base + ms, us, tmr0, event_id & PENDING),
+                event_id & ~PENDING))
+        yield dump
+        pos = end + 1
+
+
+def histogram(values):
+    """Prints values in power-of-two buckets."""
+    buckets = {}
+    for value in values:
+        bucket = max(value, 1).bit_length() - 1
+        buckets[bucket] = buckets.get(bucket, 0) + 1
+    width = max(buckets.values())
+    for bucket in range(min(buckets), max(buckets) + 1):
+        n = buckets.get(bucket, 0)
+        print("    %8d - %8d us %6d %s" % (
+            (1 << bucket) if bucket else 0, (2 << bucket) - 1, n,
+            "#" * ((n * 40 + width - 1) // width)))
+
+
+def statistics(title, values):
+    if not values:
+        print("%s: no samples" % title)
+        return
+    print("%s: %d samples, min %d us, avg %d us, max %d us" % (
+        title, len(values), min(values), sum(values) // len(values),
+        max(values)))
+    histogram(values)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", default="-",
+                        help="dump file or serial device, - for stdin")
+    parser.add_argument("--list", action="store_true",
+                        help="print every event")
+    parser.add_argument("--name", action="append", default=[],
+                        metavar="ID=NAME", help="name of an event id")
+    parser.add_argument("--pair", action="append", default=[],
+                        metavar="START:END",
+                        help="latency from each START event to the next "
+                             "END event")
+    args = parser.parse_args()
+
+    names = {}
+    for name in args.name:
+        event_id, _, text = name.partition("=")
+        names[int(event_id, 0)] = text
+    pairs = [tuple(int(i, 0) for i in pair.split(":")) for pair in args.pair]
+
+    def event_name(event_id):
+        return names.get(event_id, str(event_id))
+
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as f:
+            data = f.read()
+
+    intervals = {}
+    latencies = {pair: [] for pair in pairs}
+    dump_count = event_count = lost = 0
+    for dump in parse_dumps(data):
+        dump_count += 1
+        event_count += len(dump.events)
+        lost += dump.lost
+        if args.list:
+            print("dump %d: %d events, %d lost, period %d us, "
+                  "resolution %d us" % (dump_count, len(dump.events),
+                                        dump.lost, dump.period_us,
+                                        1 << dump.tick_us_shift))
+        if not dump.events:
+            continue
+
+        first = dump.events[0][0]
+        last_time = {}
+        open_pairs = {}
+        previous = first
+        for time, event_id in dump.events:
+            if args.list:
+                print("  %10d us %+8d us  %s" % (
+                    time - first, time - previous, event_name(event_id)))
+            previous = time
+            if event_id in last_time:
+                intervals.setdefault(event_id, []).append(
+                    time - last_time[event_id])
+            last_time[event_id] = time
+            for pair in pairs:
+                if event_id == pair[1] and pair in open_pairs:
+                    latencies[pair].append(time - open_pairs.pop(pair))
+                if event_id == pair[0]:
+                    open_pairs[pair] = time
+
+    print("%d dumps, %d events, %d lost" % (dump_count, event_count, lost))
+    for event_id in sorted(intervals):
+        statistics("interval %s" % event_name(event_id), intervals[event_id])
+    for pair in pairs:
+        statistics("latency %s -> %s" % (event_name(pair[0]),
+                                         event_name(pair[1])),
+                   latencies[pair])
+    return 0 if dump_count else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
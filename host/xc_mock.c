@@ -0,0 +1,96 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <xc.h>
+
+// Page aligned, so that host/bench.c can protect the registers to count
+// accesses
+volatile unsigned char __xc_mock_sfr[0x1000] __attribute__((aligned(0x1000)));
+
+uint16_t __xc_mock_flash[__XC_MOCK_FLASH_WORDS];
+uint8_t __xc_mock_flash_worn[__XC_MOCK_FLASH_WORDS / __XC_MOCK_FLASH_ROW_WORDS];
+
+static uint16_t latches[__XC_MOCK_FLASH_ROW_WORDS];
+
+static void clear_latches(void) {
+    uint8_t i;
+    
+    for (i = 0; i < __XC_MOCK_FLASH_ROW_WORDS; i++) {
+        latches[i] = 0x3FFF;
+    }
+}
+
+void __xc_mock_flash_reset(void) {
+    uint16_t i;
+    
+    for (i = 0; i < __XC_MOCK_FLASH_WORDS; i++) {
+        __xc_mock_flash[i] = 0x3FFF;
+    }
+    for (i = 0; i < sizeof(__xc_mock_flash_worn); i++) {
+        __xc_mock_flash_worn[i] = 0;
+    }
+    clear_latches();
+}
+
+/*
+ * Program memory controller of the PIC16(L)F1705/1709. Reads, row erases,
+ * latch loads and row writes behave like the hardware, where programming
+ * can only clear bits of an erased word. The unlock sequence is reduced to
+ * WREN and the last PMCON2 write.
+ */
+void __xc_mock_nop(void) {
+    uint16_t address = (uint16_t) (((PMADRH << 8) | PMADRL) 
+        & (__XC_MOCK_FLASH_WORDS - 1));
+    uint16_t row = address & ~(__XC_MOCK_FLASH_ROW_WORDS - 1);
+    uint8_t i;
+    
+    if (PMCON1bits.CFGS) {
+        // Configuration space is not modelled
+        PMCON1bits.RD = 0;
+        PMCON1bits.WR = 0;
+        return;
+    }
+    if (PMCON1bits.RD) {
+        PMDATL = (uint8_t) __xc_mock_flash[address];
+        PMDATH = (uint8_t) (__xc_mock_flash[address] >> 8);
+        PMCON1bits.RD = 0;
+    }
+    if (!PMCON1bits.WR) {
+        return;
+    }
+    PMCON1bits.WR = 0;
+    if (!PMCON1bits.WREN || (PMCON2 != 0xAA)) {
+        return;
+    }
+    PMCON2 = 0;
+    
+    if (PMCON1bits.FREE) {
+        for (i = 0; i < __XC_MOCK_FLASH_ROW_WORDS; i++) {
+            __xc_mock_flash[row + i] = 0x3FFF;
+        }
+        return;
+    }
+    latches[address - row] = (uint16_t) (((PMDATH << 8) | PMDATL) & 0x3FFF);
+    if (PMCON1bits.LWLO) {
+        return;
+    }
+    if (!__xc_mock_flash_worn[row / __XC_MOCK_FLASH_ROW_WORDS]) {
+        for (i = 0; i < __XC_MOCK_FLASH_ROW_WORDS; i++) {
+            __xc_mock_flash[row + i] &= latches[i];
+        }
+    }
+    clear_latches();
+}
@@ -0,0 +1,168 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/adc.h"
+
+#include <xc.h>
+
+#include <string.h>
+
+static uint8_t channels[LIBPIC170X_ADC_MAX_CHANNELS];
+static uint8_t channel_count = 0;
+
+// Scan state, only accessed by adc_ih() while scanning
+static uint16_t accumulators[LIBPIC170X_ADC_MAX_CHANNELS];
+static uint8_t current = 0;
+static uint8_t pass = 0;
+
+// adc_ih() only writes the buffer that is not published in front, readers
+// use seq to detect a publication during their copy.
+static uint16_t snapshots[2][LIBPIC170X_ADC_MAX_CHANNELS];
+static volatile uint8_t front = 0;
+static volatile uint8_t seq = 0;
+
+static void select_channel(uint8_t channel) {
+    ADCON0 = (uint8_t) ((channel << 2) | 0x01);
+}
+
+uint8_t adc_pin_channel(const PinDef* def) {
+    if (!def) {
+        return ADC_CHANNEL_NONE;
+    }
+    
+    switch (def->pin_pps) {
+        case PIN_PPS(RA0): return 0;
+        case PIN_PPS(RA1): return 1;
+        case PIN_PPS(RA2): return 2;
+        case PIN_PPS(RA4): return 3;
+        case PIN_PPS(RC0): return 4;
+        case PIN_PPS(RC1): return 5;
+        case PIN_PPS(RC2): return 6;
+        case PIN_PPS(RC3): return 7;
+#if defined(PIC16F1709) || defined(PIC16LF1709)
+        case PIN_PPS(RC6): return 8;
+        case PIN_PPS(RC7): return 9;
+        case PIN_PPS(RB4): return 10;
+        case PIN_PPS(RB5): return 11;
+#endif
+        default: return ADC_CHANNEL_NONE;
+    }
+}
+
+bool adc_scan_init_clock(const PinDef* const* pins, uint8_t count, uint8_t trigger, uint8_t clock_bits) {
+    uint8_t i;
+    bool gie;
+    
+    if ((count == 0) || (count > LIBPIC170X_ADC_MAX_CHANNELS)) {
+        return false;
+    }
+    for (i = 0; i < count; i++) {
+        if (adc_pin_channel(pins[i]) == ADC_CHANNEL_NONE) {
+            return false;
+        }
+    }
+    
+    gie = GIE;
+    GIE = 0;
+    ADIE = 0;
+    for (i = 0; i < count; i++) {
+        channels[i] = adc_pin_channel(pins[i]);
+        pin_set_pin_mode(pins[i], false);
+        pin_set_input_mode(pins[i], PIN_INPUT_MODE_ANALOG);
+    }
+    channel_count = count;
+    memset(accumulators, 0, sizeof(accumulators));
+    memset(snapshots, 0, sizeof(snapshots));
+    current = 0;
+    pass = 0;
+    
+    // Right-justified result, VDD/VSS references
+    ADCON1 = (uint8_t) (0x80 | (clock_bits << 4));
+    ADCON2 = (uint8_t) (trigger << 4);
+    select_channel(channels[0]);
+    
+    ADIF = 0;
+    ADIE = 1;
+    PEIE = 1;
+    if (gie) GIE = 1;
+    return true;
+}
+
+void adc_scan_stop(void) {
+    ADIE = 0;
+    ADCON2 = 0;
+    ADCON0 = 0;
+}
+
+void adc_ih(void) {
+    uint8_t i, back;
+    
+    if (!(ADIE && ADIF)) {
+        return;
+    }
+    ADIF = 0;
+    
+    accumulators[current] += (uint16_t) ((ADRESH << 8) | ADRESL);
+    
+    if (++current >= channel_count) {
+        current = 0;
+        if (++pass >= ADC_OVERSAMPLE_COUNT) {
+            pass = 0;
+            
+            back = front ^ 1;
+            for (i = 0; i < channel_count; i++) {
+                snapshots[back][i] = accumulators[i] >> LIBPIC170X_ADC_OVERSAMPLE_BITS;
+                accumulators[i] = 0;
+            }
+            front = back;
+            seq++;
+        }
+    }
+    
+    // The input settles until the next trigger starts the conversion
+    select_channel(channels[current]);
+}
+
+uint8_t adc_read(uint16_t* values) {
+    uint8_t s, i;
+    const uint16_t* snapshot;
+    
+    do {
+        s = seq;
+        snapshot = snapshots[front];
+        for (i = 0; i < channel_count; i++) {
+            values[i] = snapshot[i];
+        }
+    } while (s != seq);
+    
+    return s;
+}
+
+uint16_t adc_get(uint8_t index) {
+    uint8_t s;
+    uint16_t value;
+    
+    if (index >= channel_count) {
+        return 0;
+    }
+    
+    do {
+        s = seq;
+        value = snapshots[front][index];
+    } while (s != seq);
+    
+    return value;
+}
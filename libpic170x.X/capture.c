@@ -0,0 +1,265 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/capture.h"
+
+#include <xc.h>
+
+// CCPxCON values: capture on every falling edge, CCPxCON values of the
+// CAPTURE_MODE_ values for the rising edges
+#define CCP_CAPTURE_FALLING 0x04
+static const uint8_t c_mode_bits[CAPTURE_MODE_PULSE + 1] = {
+    0x05, 0x06, 0x07, 0x05
+};
+// log2 of the periods per capture of the CAPTURE_MODE_ values
+static const uint8_t c_period_shift[CAPTURE_MODE_PULSE + 1] = {
+    0, 2, 4, 0
+};
+
+// last_rise holds a valid timestamp
+#define FLAG_STARTED 0x01
+// The CCP module waits for the falling edge of a pulse
+#define FLAG_FALLING 0x02
+
+typedef struct {
+    //! Timestamp of the last rising edge capture
+    uint32_t last_rise;
+    //! Timestamp at which the current averaging span started
+    uint32_t first_rise;
+    //! Ticks between the last two rising edge captures
+    uint32_t period;
+    //! Ticks of the last high pulse
+    uint32_t high;
+    //! Rising edge captures since first_rise
+    uint16_t captures;
+    uint8_t mode;
+    uint8_t flags;
+} CaptureChannel;
+
+static CaptureChannel channels[CAPTURE_CHANNEL_COUNT];
+// Upper 16 bits of the 32-bit timestamps
+static uint16_t overflows;
+
+// floor(a * b / c) for results that fit into 32 bits. The product is
+// processed bit by bit, so no 64-bit type is required.
+static uint32_t mul_div(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t a_quot = a / c, a_rem = a % c;
+    uint32_t quot = 0, rem = 0;
+    uint8_t i;
+
+    // Invariant: quot * c + rem == a * (processed upper bits of b)
+    for (i = 32; i > 0; i--) {
+        quot <<= 1;
+        if (rem >= c - rem) {
+            rem -= c - rem;
+            quot++;
+        } else {
+            rem <<= 1;
+        }
+        if (b & 0x80000000ul) {
+            quot += a_quot;
+            if (rem >= c - a_rem) {
+                rem -= c - a_rem;
+                quot++;
+            } else {
+                rem += a_rem;
+            }
+        }
+        b <<= 1;
+    }
+    return quot;
+}
+
+// Processes a capture and returns the CCPxCON value for the next edge
+static uint8_t process_capture(CaptureChannel* channel, uint16_t captured) {
+    uint16_t upper = overflows;
+    uint32_t now;
+
+    // A pending overflow has not been counted yet. Small captured values
+    // were taken after it, large values right before it.
+    if (TMR1IF && !(captured & 0x8000)) {
+        upper++;
+    }
+    now = ((uint32_t) upper << 16) | captured;
+
+    if (channel->flags & FLAG_FALLING) {
+        channel->high = now - channel->last_rise;
+        channel->flags &= (uint8_t) ~FLAG_FALLING;
+        return c_mode_bits[channel->mode];
+    }
+
+    if (channel->flags & FLAG_STARTED) {
+        channel->period = now - channel->last_rise;
+        if (channel->captures == (0xFFFFu >> c_period_shift[channel->mode])) {
+            // Averaging is not read out, keep the most recent periods only
+            channel->first_rise = channel->last_rise;
+            channel->captures = 0;
+        }
+        channel->captures++;
+    } else {
+        channel->first_rise = now;
+        channel->flags |= FLAG_STARTED;
+    }
+    channel->last_rise = now;
+
+    if (channel->mode == CAPTURE_MODE_PULSE) {
+        channel->flags |= FLAG_FALLING;
+        return CCP_CAPTURE_FALLING;
+    }
+    return c_mode_bits[channel->mode];
+}
+
+void capture_init(uint8_t prescale) {
+    T1CON = 0;
+    TMR1IE = 0;
+    TMR1H = 0;
+    TMR1L = 0;
+    overflows = 0;
+    TMR1IF = 0;
+    // Fosc/4, prescaler, TMR1ON
+    T1CON = (uint8_t) (((prescale & 0x03) << 4) | 0x01);
+    TMR1IE = 1;
+    PEIE = 1;
+}
+
+void capture_enable(uint8_t channel, const PinDef* pin, uint8_t mode) {
+    CaptureChannel* state;
+    bool gie;
+
+    if ((channel >= CAPTURE_CHANNEL_COUNT) || (mode > CAPTURE_MODE_PULSE)) {
+        return;
+    }
+
+    pin_set_pin_mode(pin, false);
+    pin_set_input_mode(pin, PIN_INPUT_MODE_DIGITAL);
+
+    gie = GIE;
+    GIE = 0;
+    state = &channels[channel];
+    state->mode = mode;
+    state->flags = 0;
+    state->captures = 0;
+    state->period = 0;
+    state->high = 0;
+    state->first_rise = 0;
+    state->last_rise = 0;
+
+    // Changing the capture mode can cause a false capture, so the flag is
+    // cleared after the module was configured
+    switch (channel) {
+        case CAPTURE_CHANNEL_CCP1:
+            CCP1IE = 0;
+            CCP1CON = 0;
+            CCP1PPS = pin->pin_pps;
+            CCP1CON = c_mode_bits[mode];
+            CCP1IF = 0;
+            CCP1IE = 1;
+            break;
+        case CAPTURE_CHANNEL_CCP2:
+            CCP2IE = 0;
+            CCP2CON = 0;
+            CCP2PPS = pin->pin_pps;
+            CCP2CON = c_mode_bits[mode];
+            CCP2IF = 0;
+            CCP2IE = 1;
+            break;
+    }
+    if (gie) GIE = 1;
+}
+
+void capture_disable(uint8_t channel) {
+    switch (channel) {
+        case CAPTURE_CHANNEL_CCP1:
+            CCP1IE = 0;
+            CCP1CON = 0;
+            CCP1IF = 0;
+            break;
+        case CAPTURE_CHANNEL_CCP2:
+            CCP2IE = 0;
+            CCP2CON = 0;
+            CCP2IF = 0;
+            break;
+    }
+}
+
+bool capture_read(uint8_t channel, CaptureResult* result) {
+    CaptureChannel* state;
+    uint16_t captures;
+    uint8_t shift;
+    bool gie;
+
+    if (channel >= CAPTURE_CHANNEL_COUNT) {
+        return false;
+    }
+    state = &channels[channel];
+
+    gie = GIE;
+    GIE = 0;
+    result->period = state->period;
+    result->high = state->high;
+    result->span = state->last_rise - state->first_rise;
+    captures = state->captures;
+    state->first_rise = state->last_rise;
+    state->captures = 0;
+    if (gie) GIE = 1;
+
+    shift = c_period_shift[state->mode];
+    result->period >>= shift;
+    result->periods = (uint16_t) (captures << shift);
+    return captures != 0;
+}
+
+uint32_t capture_frequency(const CaptureResult* result, uint32_t ticks_per_second) {
+    if (!result->periods || !result->span) {
+        return 0;
+    }
+    return mul_div(ticks_per_second, (uint32_t) result->periods * 1000ul, result->span);
+}
+
+uint16_t capture_duty(const CaptureResult* result, uint16_t max) {
+    if (!result->period) {
+        return 0;
+    }
+    if (result->high >= result->period) {
+        return max;
+    }
+    return (uint16_t) mul_div(result->high, max, result->period);
+}
+
+void capture_ih(void) {
+    uint8_t next;
+
+    if (CCP1IE && CCP1IF) {
+        next = process_capture(&channels[CAPTURE_CHANNEL_CCP1],
+            (uint16_t) ((CCPR1H << 8) | CCPR1L));
+        if (CCP1CON != next) {
+            CCP1CON = next;
+        }
+        CCP1IF = 0;
+    }
+    if (CCP2IE && CCP2IF) {
+        next = process_capture(&channels[CAPTURE_CHANNEL_CCP2],
+            (uint16_t) ((CCPR2H << 8) | CCPR2L));
+        if (CCP2CON != next) {
+            CCP2CON = next;
+        }
+        CCP2IF = 0;
+    }
+    if (TMR1IE && TMR1IF) {
+        overflows++;
+        TMR1IF = 0;
+    }
+}
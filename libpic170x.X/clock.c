@@ -0,0 +1,146 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/clock.h"
+
+#include <xc.h>
+
+// OSCCON values indexed by the CLOCK_ values, same as OSCCON_BITS in freq.h
+static const uint8_t c_osccon_bits[CLOCK_32MHZ + 1] = {
+    0b00111010, 0b01011010, 0b01100010, 0b01101010,
+    0b01110010, 0b01111010, 0b11110010
+};
+
+// SPLLEN and IRCF bits of OSCCON
+#define OSCCON_FREQUENCY_MASK 0xF8
+
+uint8_t clock_get(void) {
+    uint8_t clock;
+
+    for (clock = 0; clock <= CLOCK_32MHZ; clock++) {
+        if (((OSCCON ^ c_osccon_bits[clock]) & OSCCON_FREQUENCY_MASK) == 0) {
+            return clock;
+        }
+    }
+    return CLOCK_UNKNOWN;
+}
+
+bool clock_timer0_settings(Timer0Clock* settings, uint8_t clock, uint32_t period_us, bool exact) {
+    // Same derivation as in freq.h: an instruction cycle takes 8 >> clock us
+    // and a TMR0 increment 1 << shift us.
+    uint8_t shift_min = (clock >= 3) ? 0 : (uint8_t) (3 - clock);
+    uint8_t shift_max = (uint8_t) (11 - clock);
+    uint8_t shift, prescale_log2;
+
+    if (clock > CLOCK_32MHZ) {
+        return false;
+    }
+
+    if (exact) {
+        // Smallest shift for which the period fits into the 8-bit counter
+        for (shift = shift_min; shift <= shift_max; shift++) {
+            if ((period_us >> shift) <= 256) {
+                break;
+            }
+        }
+        // The reload would clear the prescaler, so an exact period must
+        // not need one
+        if ((shift > shift_max) || (shift + clock != 3)
+                || ((period_us & ((1ul << shift) - 1)) != 0)) {
+            return false;
+        }
+        settings->period_us = period_us;
+        settings->preload = (uint8_t) (256 - (period_us >> shift));
+    } else {
+        // Largest shift for which a full 8-bit counter period does not
+        // exceed the target
+        for (shift = shift_max; shift > shift_min; shift--) {
+            if ((256ul << shift) <= period_us) {
+                break;
+            }
+        }
+        if ((256ul << shift) > period_us) {
+            return false;
+        }
+        settings->period_us = 256ul << shift;
+        settings->preload = 0;
+    }
+
+    prescale_log2 = (uint8_t) (shift + clock - 3);
+    if (prescale_log2 == 0) {
+        // PSA set, a TMR0 write inhibits the next two increments
+        settings->prescale_bits = 0x08;
+        settings->reload = (uint8_t) (settings->preload + 2);
+    } else {
+        settings->prescale_bits = (uint8_t) (prescale_log2 - 1);
+        settings->reload = settings->preload;
+    }
+    settings->tick_us_shift = shift;
+    settings->ms_inc = (uint16_t) (settings->period_us / 1000);
+    settings->us_inc = (uint16_t) (settings->period_us % 1000);
+    settings->us_carry = (uint16_t) (1000 - settings->us_inc);
+    return true;
+}
+
+bool clock_set(Timer0* timer0, uint8_t clock) {
+    Timer0Clock settings;
+    uint8_t ticks;
+    bool gie;
+
+    // Soft timer ticks, debounce times and other values derived from
+    // TIMER0_PERIOD_US at compile time stay valid only if the period and 
+    // the preload do not change. Only the prescaler may be replaced.
+    if (!clock_timer0_settings(&settings, clock, pic170x_timer0_clock.period_us,
+                pic170x_timer0_clock.preload != 0)
+            || (settings.period_us != pic170x_timer0_clock.period_us)
+            || (settings.preload != pic170x_timer0_clock.preload)) {
+        return false;
+    }
+    if (!timer0) timer0 = &pic170x_timer0;
+
+    gie = GIE;
+    GIE = 0;
+
+    // The CPU and timer0 keep running on the old clock until the new
+    // oscillator is stable
+    OSCCON = c_osccon_bits[clock];
+    if (clock == CLOCK_32MHZ) {
+        while (!OSCSTATbits.PLLR) {}
+    } else if (clock == CLOCK_500KHZ) {
+        while (!OSCSTATbits.MFIOFR) {}
+    } else {
+        while (!OSCSTATbits.HFIOFS) {}
+    }
+
+    // Account the elapsed part of the current period with the old settings,
+    // including an overflow that has not been processed yet
+    if (TMR0IF) {
+        __LIBPIC170X_TIMER0_UPDATE_WITH(timer0, pic170x_timer0_clock.ms_inc,
+            pic170x_timer0_clock.us_inc, pic170x_timer0_clock.us_carry,
+            pic170x_timer0_clock.preload, pic170x_timer0_clock.reload);
+    }
+    ticks = (uint8_t) (TMR0 - pic170x_timer0_clock.preload);
+    timer0_advance(timer0, (uint32_t) ticks << pic170x_timer0_clock.tick_us_shift);
+
+    // Start a new period with the new settings
+    pic170x_timer0_clock = settings;
+    OPTION_REG = (unsigned char) (OPTION_REG & 0b11010000) | settings.prescale_bits;
+    TMR0 = settings.preload;
+    TMR0IF = 0;
+
+    if (gie) GIE = 1;
+    return true;
+}
@@ -0,0 +1,118 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/debounce.h"
+
+#include <xc.h>
+
+#define PORT_COUNT 3
+
+static uint8_t state[PORT_COUNT];
+// Vertical 2-bit counters, one bit per pin in each byte
+static uint8_t count0[PORT_COUNT], count1[PORT_COUNT];
+static uint8_t rising[PORT_COUNT], falling[PORT_COUNT];
+
+/*
+ * Debounces one port. The counters of pins whose sample equals the state
+ * are held at 3, the others count down. A pin whose counter wraps from 0 
+ * to 3 after DEBOUNCE_SAMPLES differing samples toggles its state. The
+ * port index is a constant in every expansion, so all accesses are direct.
+ */
+#define DEBOUNCE_PORT(port, sample) \
+    do { \
+        uint8_t changed = (uint8_t) ((sample) ^ state[port]); \
+        uint8_t toggled; \
+        count0[port] = (uint8_t) ~(count0[port] & changed); \
+        count1[port] = (uint8_t) (count0[port] ^ (count1[port] & changed)); \
+        toggled = (uint8_t) (changed & count0[port] & count1[port]); \
+        state[port] ^= toggled; \
+        rising[port] |= (uint8_t) (toggled & state[port]); \
+        falling[port] |= (uint8_t) (toggled & ~state[port]); \
+    } while (0)
+
+void debounce_init(void) {
+    uint8_t port;
+    bool gie = GIE;
+    
+    GIE = 0;
+    for (port = 0; port < PORT_COUNT; port++) {
+        state[port] = 0;
+        count0[port] = 0xFF;
+        count1[port] = 0xFF;
+        rising[port] = 0;
+        falling[port] = 0;
+    }
+    state[DEBOUNCE_PORT_A] = PORTA;
+#if defined(PIC16F1709) || defined(PIC16LF1709)
+    state[DEBOUNCE_PORT_B] = PORTB;
+#endif
+    state[DEBOUNCE_PORT_C] = PORTC;
+    if (gie) GIE = 1;
+}
+
+void debounce_tick(void) {
+    DEBOUNCE_PORT(DEBOUNCE_PORT_A, PORTA);
+#if defined(PIC16F1709) || defined(PIC16LF1709)
+    DEBOUNCE_PORT(DEBOUNCE_PORT_B, PORTB);
+#endif
+    DEBOUNCE_PORT(DEBOUNCE_PORT_C, PORTC);
+}
+
+uint8_t debounce_state(uint8_t port) {
+    if (port >= PORT_COUNT) {
+        return 0;
+    }
+    return state[port];
+}
+
+bool debounce_get(PinId id) {
+    if (id == PIN_ID_NONE) {
+        return false;
+    }
+    return (debounce_state(id >> 3) & PIN_ID_MASK(id)) != 0;
+}
+
+uint8_t debounce_rising(uint8_t port, uint8_t mask) {
+    uint8_t edges;
+    bool gie;
+    
+    if (port >= PORT_COUNT) {
+        return 0;
+    }
+    
+    gie = GIE;
+    GIE = 0;
+    edges = (uint8_t) (rising[port] & mask);
+    rising[port] &= (uint8_t) ~edges;
+    if (gie) GIE = 1;
+    return edges;
+}
+
+uint8_t debounce_falling(uint8_t port, uint8_t mask) {
+    uint8_t edges;
+    bool gie;
+    
+    if (port >= PORT_COUNT) {
+        return 0;
+    }
+    
+    gie = GIE;
+    GIE = 0;
+    edges = (uint8_t) (falling[port] & mask);
+    falling[port] &= (uint8_t) ~edges;
+    if (gie) GIE = 1;
+    return edges;
+}
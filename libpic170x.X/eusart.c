@@ -0,0 +1,144 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/eusart.h"
+#include "libpic170x/ring_buffer.h"
+
+#include <xc.h>
+
+static uint8_t tx_storage[LIBPIC170X_EUSART_TX_BUFFER_SIZE];
+static uint8_t rx_storage[LIBPIC170X_EUSART_RX_BUFFER_SIZE];
+// Produced by the main loop, consumed by eusart_ih()
+static RingBuffer tx_buffer;
+// Produced by eusart_ih(), consumed by the main loop
+static RingBuffer rx_buffer;
+static uint8_t rx_dropped = 0;
+
+static void count_rx_drop(void) {
+    if (rx_dropped != 0xFF) {
+        rx_dropped++;
+    }
+}
+
+void eusart_init(uint16_t brg, const PinDef* tx_pin, const PinDef* rx_pin) {
+    bool gie = GIE;
+    
+    GIE = 0;
+    RC1STA = 0;
+    TX1STA = 0;
+    TXIE = 0;
+    RCIE = 0;
+    
+    ring_buffer_init(&tx_buffer, tx_storage, LIBPIC170X_EUSART_TX_BUFFER_SIZE, 1);
+    ring_buffer_init(&rx_buffer, rx_storage, LIBPIC170X_EUSART_RX_BUFFER_SIZE, 1);
+    rx_dropped = 0;
+    
+    BAUD1CONbits.BRG16 = 1;
+    TX1STAbits.BRGH = 1;
+    SP1BRGL = (uint8_t) brg;
+    SP1BRGH = (uint8_t) (brg >> 8);
+    
+    if (tx_pin) {
+        pin_set_output_source(tx_pin, PIN_OUTPUT_SOURCE_TX_CK);
+        pin_set_pin_mode(tx_pin, true);
+        TX1STAbits.TXEN = 1;
+    }
+    if (rx_pin) {
+        RXPPS = rx_pin->pin_pps;
+        pin_set_pin_mode(rx_pin, false);
+        pin_set_input_mode(rx_pin, PIN_INPUT_MODE_DIGITAL);
+        RC1STAbits.CREN = 1;
+        RCIE = 1;
+    }
+    RC1STAbits.SPEN = 1;
+    
+    PEIE = 1;
+    if (gie) GIE = 1;
+}
+
+void eusart_ih(void) {
+    uint8_t value;
+    
+    if (RC1STAbits.OERR) {
+        // An overrun stops reception until CREN is toggled
+        RC1STAbits.CREN = 0;
+        RC1STAbits.CREN = 1;
+        count_rx_drop();
+    }
+    // RCIF stays set while the receive FIFO holds more bytes, so remaining
+    // bytes re-enter the interrupt handler.
+    if (RCIF) {
+        value = RC1REG;
+        if (!ring_buffer_push_byte(&rx_buffer, value)) {
+            count_rx_drop();
+        }
+    }
+    
+    if (TXIE && TXIF) {
+        if (ring_buffer_pop_byte(&tx_buffer, &value)) {
+            TX1REG = value;
+        } else {
+            TXIE = 0;
+        }
+    }
+}
+
+uint8_t eusart_write(const uint8_t* data, uint8_t length) {
+    uint8_t count = ring_buffer_push_bulk(&tx_buffer, data, length);
+    
+    // eusart_ih() only clears TXIE after finding the buffer empty, setting
+    // it after the push re-arms the interrupt in any interleaving.
+    if (count) {
+        TXIE = 1;
+    }
+    return count;
+}
+
+uint8_t eusart_write_string(const char* str) {
+    uint8_t count = 0;
+    
+    while (*str) {
+        if (!ring_buffer_push_byte(&tx_buffer, (uint8_t) *str)) {
+            break;
+        }
+        str++;
+        count++;
+    }
+    if (count) {
+        TXIE = 1;
+    }
+    return count;
+}
+
+uint8_t eusart_write_space(void) {
+    return ring_buffer_space(&tx_buffer);
+}
+
+bool eusart_tx_idle(void) {
+    return (ring_buffer_count(&tx_buffer) == 0) && TX1STAbits.TRMT;
+}
+
+uint8_t eusart_read(uint8_t* data, uint8_t max) {
+    return ring_buffer_pop_bulk(&rx_buffer, data, max);
+}
+
+uint8_t eusart_read_count(void) {
+    return ring_buffer_count(&rx_buffer);
+}
+
+uint8_t eusart_rx_dropped(void) {
+    return rx_dropped;
+}
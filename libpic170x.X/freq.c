@@ -1,4 +1,3 @@
 #include "libpic170x/freq.h"
 
-const uint32_t __LIBPIC170X_BUILT_XTAL_FREQ = _XTAL_FREQ;
-const char* __LIBPIC170X_BUILT_DEVICE_NAME = __LIBPIC170X_DEVICE_NAME;
+const uint8_t __LIBPIC170X_CHIP_TAG(__libpic170x_built_for) = 1;
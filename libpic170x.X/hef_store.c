@@ -0,0 +1,217 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/hef_store.h"
+
+#include <xc.h>
+
+#include <string.h>
+
+// Row layout: sequence number, records, checksum. The checksum is the
+// inverted sum of the other bytes, so neither an erased (all 0xFF) nor a
+// cleared row is valid.
+#define SEQUENCE_OFFSET 0
+#define RECORD_OFFSET 1
+#define CHECKSUM_OFFSET (HEF_STORE_ROW_SIZE - 1)
+
+#define NO_ROW 0xFF
+
+// RAM copy of the newest row
+static uint8_t row_data[HEF_STORE_ROW_SIZE];
+// Row that holds the committed state, NO_ROW if none
+static uint8_t current_row;
+static bool dirty;
+
+static uint16_t row_address(uint8_t row) {
+    return HEF_STORE_ADDRESS + (uint16_t) row * HEF_STORE_ROW_SIZE;
+}
+
+static uint8_t flash_read(uint16_t address) {
+    PMADRH = (uint8_t) (address >> 8);
+    PMADRL = (uint8_t) address;
+    PMCON1bits.CFGS = 0;
+    PMCON1bits.RD = 1;
+    NOP();
+    NOP();
+    return PMDATL;
+}
+
+// Unlock sequence that starts the operation selected in PMCON1. Must run
+// with interrupts disabled, the CPU stalls until an erase or write is done.
+static void flash_unlock(void) {
+    PMCON2 = 0x55;
+    PMCON2 = 0xAA;
+    PMCON1bits.WR = 1;
+    NOP();
+    NOP();
+}
+
+static void flash_erase_row(uint8_t row) {
+    uint16_t address = row_address(row);
+    bool gie = GIE;
+
+    GIE = 0;
+    PMADRH = (uint8_t) (address >> 8);
+    PMADRL = (uint8_t) address;
+    PMCON1bits.CFGS = 0;
+    PMCON1bits.FREE = 1;
+    PMCON1bits.WREN = 1;
+    flash_unlock();
+    PMCON1bits.WREN = 0;
+    if (gie) GIE = 1;
+}
+
+// Erases the row, programs row_data into it and verifies the result
+static bool flash_write_row(uint8_t row) {
+    uint16_t address = row_address(row);
+    uint8_t i;
+    bool gie;
+
+    flash_erase_row(row);
+
+    gie = GIE;
+    GIE = 0;
+    PMADRH = (uint8_t) (address >> 8);
+    PMCON1bits.CFGS = 0;
+    PMCON1bits.FREE = 0;
+    PMCON1bits.LWLO = 1;
+    PMCON1bits.WREN = 1;
+    for (i = 0; i < HEF_STORE_ROW_SIZE; i++) {
+        // Rows are aligned, PMADRH is the same for the whole row. The
+        // upper bits of each word are not HEF, they are left erased.
+        PMADRL = (uint8_t) (address + i);
+        PMDATL = row_data[i];
+        PMDATH = 0x3F;
+        if (i == HEF_STORE_ROW_SIZE - 1) {
+            // Write the latches to the row with the last word
+            PMCON1bits.LWLO = 0;
+        }
+        flash_unlock();
+    }
+    PMCON1bits.WREN = 0;
+    if (gie) GIE = 1;
+
+    if (PMCON1bits.WRERR) {
+        PMCON1bits.WRERR = 0;
+        return false;
+    }
+    for (i = 0; i < HEF_STORE_ROW_SIZE; i++) {
+        if (flash_read(address + i) != row_data[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Checks the checksum of a row in flash
+static bool row_valid(uint8_t row) {
+    uint16_t address = row_address(row);
+    uint8_t i, sum = 0;
+
+    for (i = 0; i < CHECKSUM_OFFSET; i++) {
+        sum = (uint8_t) (sum + flash_read(address + i));
+    }
+    sum = (uint8_t) ~sum;
+    return flash_read(address + CHECKSUM_OFFSET) == sum;
+}
+
+bool hef_store_init(void) {
+    uint8_t row, sequence, newest_sequence = 0;
+    uint8_t i;
+
+    current_row = NO_ROW;
+    dirty = false;
+
+    // Sequence numbers of the valid rows differ by less than HEF_STORE_ROWS,
+    // so the newest row is found with wraparound-safe comparisons.
+    for (row = 0; row < HEF_STORE_ROWS; row++) {
+        if (!row_valid(row)) {
+            continue;
+        }
+        sequence = flash_read(row_address(row) + SEQUENCE_OFFSET);
+        if ((current_row == NO_ROW)
+                || ((int8_t) (uint8_t) (sequence - newest_sequence) > 0)) {
+            current_row = row;
+            newest_sequence = sequence;
+        }
+    }
+
+    if (current_row == NO_ROW) {
+        // The first commit uses sequence number 0 in row 0
+        memset(row_data, 0xFF, sizeof(row_data));
+        return false;
+    }
+    for (i = 0; i < HEF_STORE_ROW_SIZE; i++) {
+        row_data[i] = flash_read(row_address(current_row) + i);
+    }
+    return true;
+}
+
+bool hef_store_read(uint8_t offset, void* data, uint8_t length) {
+    if ((offset > HEF_STORE_SIZE) || (length > HEF_STORE_SIZE - offset)) {
+        return false;
+    }
+    memcpy(data, &row_data[RECORD_OFFSET + offset], length);
+    return true;
+}
+
+bool hef_store_write(uint8_t offset, const void* data, uint8_t length) {
+    if ((offset > HEF_STORE_SIZE) || (length > HEF_STORE_SIZE - offset)) {
+        return false;
+    }
+    if (memcmp(&row_data[RECORD_OFFSET + offset], data, length) != 0) {
+        memcpy(&row_data[RECORD_OFFSET + offset], data, length);
+        dirty = true;
+    }
+    return true;
+}
+
+bool hef_store_dirty(void) {
+    return dirty;
+}
+
+bool hef_store_commit(void) {
+    uint8_t row, attempt, i, sum;
+
+    if (!dirty) {
+        return true;
+    }
+
+    row = (current_row == NO_ROW) ? 0 : (uint8_t) ((current_row + 1) % HEF_STORE_ROWS);
+    row_data[SEQUENCE_OFFSET]++;
+    sum = 0;
+    for (i = 0; i < CHECKSUM_OFFSET; i++) {
+        sum = (uint8_t) (sum + row_data[i]);
+    }
+    row_data[CHECKSUM_OFFSET] = (uint8_t) ~sum;
+
+    // The committed row is never overwritten, a worn out row is skipped
+    for (attempt = 0; attempt < HEF_STORE_ROWS; attempt++) {
+        if (flash_write_row(row)) {
+            current_row = row;
+            dirty = false;
+            return true;
+        }
+        // Do not leave a partially written row that could pass as valid
+        flash_erase_row(row);
+        row = (uint8_t) ((row + 1) % HEF_STORE_ROWS);
+        if (row == current_row) {
+            break;
+        }
+    }
+    row_data[SEQUENCE_OFFSET]--;
+    return false;
+}
@@ -0,0 +1,248 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/i2c.h"
+#include "libpic170x/timer0.h"
+#include "libpic170x/ring_buffer.h"
+
+#include <xc.h>
+
+// Operation that the MSSP is performing, i.e. the event of the next SSP1IF
+#define STATE_IDLE 0
+#define STATE_START 1
+#define STATE_WRITE 2
+#define STATE_RESTART 3
+#define STATE_READ_ADDRESS 4
+#define STATE_READ 5
+#define STATE_ACK 6
+#define STATE_STOP 7
+
+static I2cTransaction* queue_storage[LIBPIC170X_I2C_QUEUE_SIZE];
+// Produced by i2c_submit(), consumed by start_next()
+static RingBuffer queue;
+
+// Running transaction, only accessed by the interrupt handler or with 
+// interrupts disabled
+static I2cTransaction* current = NULL;
+static uint8_t state = STATE_IDLE;
+static uint8_t byte_index;
+static uint8_t result;
+// Timer0 counter at the last bus event
+static uint32_t progress_ms;
+static uint16_t progress_us;
+
+static void start_next(void) {
+    if (!ring_buffer_pop(&queue, &current)) {
+        current = NULL;
+        state = STATE_IDLE;
+        return;
+    }
+    
+    progress_ms = pic170x_timer0.ms;
+    progress_us = pic170x_timer0.us;
+    byte_index = 0;
+    state = STATE_START;
+    SSP1CON2bits.SEN = 1;
+}
+
+static void finish(uint8_t status) {
+    I2cTransaction* done = current;
+    
+    current = NULL;
+    done->status = status;
+    if (done->callback) {
+        done->callback(done);
+    }
+    start_next();
+}
+
+static void stop(uint8_t status) {
+    result = status;
+    state = STATE_STOP;
+    SSP1CON2bits.PEN = 1;
+}
+
+static void reset_mssp(void) {
+    SSP1CON1bits.SSPEN = 0;
+    SSP1IF = 0;
+    BCL1IF = 0;
+    SSP1CON1bits.SSPEN = 1;
+}
+
+void i2c_init(uint16_t clock_config, const PinDef* scl, const PinDef* sda) {
+    bool gie = GIE;
+    
+    GIE = 0;
+    SSP1CON1 = 0;
+    ring_buffer_init(&queue, queue_storage, LIBPIC170X_I2C_QUEUE_SIZE, sizeof(I2cTransaction*));
+    current = NULL;
+    state = STATE_IDLE;
+    
+    // In I2C mode the MSSP drives the pins, which must be digital inputs.
+    // Both signals are bidirectional and need the input and output PPS.
+    if (scl) {
+        pin_set_output_source(scl, PIN_OUTPUT_SOURCE_SCK_SCL);
+        SSPCLKPPS = scl->pin_pps;
+        pin_set_pin_mode(scl, false);
+        pin_set_input_mode(scl, PIN_INPUT_MODE_DIGITAL);
+    }
+    if (sda) {
+        pin_set_output_source(sda, PIN_OUTPUT_SOURCE_SDA);
+        SSPDATPPS = sda->pin_pps;
+        pin_set_pin_mode(sda, false);
+        pin_set_input_mode(sda, PIN_INPUT_MODE_DIGITAL);
+    }
+    
+    // SMP = 1 disables slew rate control for standard mode
+    SSP1STAT = (clock_config & 0x0100) ? 0x00 : 0x80;
+    SSP1ADD = (uint8_t) clock_config;
+    SSP1CON2 = 0;
+    SSP1CON1 = 0x08;    // I2C master, Fosc / (4 * (SSP1ADD + 1))
+    SSP1CON1bits.SSPEN = 1;
+    
+    SSP1IF = 0;
+    BCL1IF = 0;
+    SSP1IE = 1;
+    BCL1IE = 1;
+    PEIE = 1;
+    if (gie) GIE = 1;
+}
+
+bool i2c_submit(I2cTransaction* transaction) {
+    bool gie;
+    
+    transaction->status = I2C_STATUS_PENDING;
+    if (!ring_buffer_push(&queue, &transaction)) {
+        return false;
+    }
+    
+    gie = GIE;
+    GIE = 0;
+    if (state == STATE_IDLE) {
+        start_next();
+    }
+    if (gie) GIE = 1;
+    return true;
+}
+
+bool i2c_busy(void) {
+    return (state != STATE_IDLE) || ring_buffer_count(&queue);
+}
+
+void i2c_ih(void) {
+    if (BCL1IF) {
+        BCL1IF = 0;
+        if (current) {
+            reset_mssp();
+            finish(I2C_STATUS_COLLISION);
+        }
+        return;
+    }
+    
+    if (!SSP1IF) {
+        return;
+    }
+    SSP1IF = 0;
+    if (!current) {
+        return;
+    }
+    progress_ms = pic170x_timer0.ms;
+    progress_us = pic170x_timer0.us;
+    
+    switch (state) {
+        case STATE_START:
+            if (current->write_length || !current->read_length) {
+                SSP1BUF = (uint8_t) (current->address << 1);
+                state = STATE_WRITE;
+            } else {
+                SSP1BUF = (uint8_t) ((current->address << 1) | 1);
+                state = STATE_READ_ADDRESS;
+            }
+            break;
+        case STATE_WRITE:
+            if (SSP1CON2bits.ACKSTAT) {
+                stop(I2C_STATUS_NACK);
+            } else if (byte_index < current->write_length) {
+                SSP1BUF = current->write_data[byte_index++];
+            } else if (current->read_length) {
+                state = STATE_RESTART;
+                SSP1CON2bits.RSEN = 1;
+            } else {
+                stop(I2C_STATUS_OK);
+            }
+            break;
+        case STATE_RESTART:
+            SSP1BUF = (uint8_t) ((current->address << 1) | 1);
+            state = STATE_READ_ADDRESS;
+            break;
+        case STATE_READ_ADDRESS:
+            if (SSP1CON2bits.ACKSTAT) {
+                stop(I2C_STATUS_NACK);
+            } else {
+                byte_index = 0;
+                state = STATE_READ;
+                SSP1CON2bits.RCEN = 1;
+            }
+            break;
+        case STATE_READ:
+            current->read_data[byte_index++] = SSP1BUF;
+            // The last byte is not acknowledged to end the read
+            SSP1CON2bits.ACKDT = (byte_index >= current->read_length);
+            state = STATE_ACK;
+            SSP1CON2bits.ACKEN = 1;
+            break;
+        case STATE_ACK:
+            if (byte_index < current->read_length) {
+                state = STATE_READ;
+                SSP1CON2bits.RCEN = 1;
+            } else {
+                stop(I2C_STATUS_OK);
+            }
+            break;
+        case STATE_STOP:
+            finish(result);
+            break;
+    }
+}
+
+/*
+ * The timer0 counter only advances in whole periods, so a counted difference
+ * of k periods means that between k - 1 and k + 1 periods have passed. The
+ * bus has been stalled for at least the timeout once the counted time 
+ * exceeds it by one period.
+ */
+static bool timed_out(void) {
+    uint32_t limit_us = (uint32_t) LIBPIC170X_I2C_TIMEOUT_MS * 1000 
+        + pic170x_timer0_clock.period_us;
+    uint32_t elapsed_ms = pic170x_timer0.ms - progress_ms;
+    
+    // Avoids an overflow of the us difference after long stalls
+    if (elapsed_ms > limit_us / 1000 + 1) {
+        return true;
+    }
+    return elapsed_ms * 1000 + pic170x_timer0.us - progress_us >= limit_us;
+}
+
+void i2c_poll(void) {
+    bool gie = GIE;
+    
+    GIE = 0;
+    if (current && timed_out()) {
+        reset_mssp();
+        finish(I2C_STATUS_TIMEOUT);
+    }
+    if (gie) GIE = 1;
+}
@@ -0,0 +1,110 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/idle.h"
+#include "libpic170x/timer0.h"
+#include "libpic170x/soft_timer.h"
+
+#include <xc.h>
+
+// Slept time that did not add up to a full timer0 period yet
+static uint32_t carry_us = 0;
+
+// Free-running timer0 periods are 256 << tick_us_shift us, so conversions
+// between us and periods are shifts. Only exact periods need a division.
+static uint32_t us_to_periods(uint32_t us) {
+    if (!pic170x_timer0_clock.preload) {
+        return us >> (pic170x_timer0_clock.tick_us_shift + 8);
+    }
+    return us / pic170x_timer0_clock.period_us;
+}
+
+static uint32_t periods_to_us(uint32_t periods) {
+    if (!pic170x_timer0_clock.preload) {
+        return periods << (pic170x_timer0_clock.tick_us_shift + 8);
+    }
+    return periods * pic170x_timer0_clock.period_us;
+}
+
+uint16_t idle_sleep(uint32_t max_us) {
+    uint8_t shift = 0;
+    uint32_t slept_us;
+    uint16_t periods;
+    
+    // Leave one watchdog step of margin, the LFINTOSC period may exceed
+    // its nominal value by more than half
+    if (max_us < (IDLE_MIN_SLEEP_US << 1)) {
+        return 0;
+    }
+    while ((shift < IDLE_MAX_SLEEP_SHIFT) 
+            && ((IDLE_MIN_SLEEP_US << (shift + 2)) <= max_us)) {
+        shift++;
+    }
+    
+    // WDTPS = shift selects a 1:(32 << shift) prescaler
+    WDTCON = (uint8_t) (shift << 1);
+    CLRWDT();
+    SWDTEN = 1;
+    SLEEP();
+    NOP();
+    SWDTEN = 0;
+    
+    // SLEEP sets nTO, it is only cleared if the watchdog woke us up
+    if (nTO) {
+        return 0;
+    }
+    
+    slept_us = carry_us + (IDLE_MIN_SLEEP_US << shift);
+    periods = (uint16_t) us_to_periods(slept_us);
+    carry_us = slept_us - periods_to_us(periods);
+    
+    timer0_advance(NULL, periods_to_us(periods));
+    return periods;
+}
+
+bool idle_until_next_timer(void) {
+    uint16_t ticks;
+    uint32_t max_us;
+    bool gie = GIE;
+    
+    // A timer0 interrupt between the expiry calculation and SLEEP would
+    // shorten the time left. With GIE cleared it stays pending instead,
+    // which turns SLEEP into a NOP, and is handled once GIE is restored.
+    GIE = 0;
+    ticks = soft_timer_next_expiry();
+    if (ticks == 0) {
+        if (gie) GIE = 1;
+        return false;
+    }
+    if (ticks == SOFT_TIMER_NO_EXPIRY) {
+        // No deadline, no margin required
+        max_us = IDLE_MAX_SLEEP_US << 1;
+    } else if (ticks > us_to_periods(IDLE_MAX_SLEEP_US << 1)) {
+        max_us = IDLE_MAX_SLEEP_US << 1;
+    } else {
+        // The current tick has partially elapsed, only the full ticks
+        // before the expiry can be slept without overshooting it.
+        max_us = periods_to_us((uint32_t) (ticks - 1));
+        if (max_us < (IDLE_MIN_SLEEP_US << 1)) {
+            if (gie) GIE = 1;
+            return false;
+        }
+    }
+    
+    soft_timer_advance(idle_sleep(max_us));
+    if (gie) GIE = 1;
+    return true;
+}
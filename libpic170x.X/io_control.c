@@ -21,19 +21,19 @@
 #include <string.h>
 
 #if defined(PIC16F1705) || defined(PIC16LF1705)
-const PinDef c_PIN_RA0 = {0b00000000, &RA0PPS, 0b00000001, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA1 = {0b00000001, &RA1PPS, 0b00000010, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA2 = {0b00000010, &RA2PPS, 0b00000100, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA3 = {0b00000011, NULL,    0b00001000, NULL,   &PORTA, NULL,    NULL};
-const PinDef c_PIN_RA4 = {0b00000100, &RA4PPS, 0b00010000, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA5 = {0b00000101, &RA5PPS, 0b00100000, &TRISA, &PORTA, NULL,    &LATA};
+const PinDef c_PIN_RA0 = {PIN_PPS(RA0), &RA0PPS, PIN_MASK(RA0), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA1 = {PIN_PPS(RA1), &RA1PPS, PIN_MASK(RA1), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA2 = {PIN_PPS(RA2), &RA2PPS, PIN_MASK(RA2), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA3 = {PIN_PPS(RA3), NULL,    PIN_MASK(RA3), NULL,   &PORTA, NULL,    NULL};
+const PinDef c_PIN_RA4 = {PIN_PPS(RA4), &RA4PPS, PIN_MASK(RA4), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA5 = {PIN_PPS(RA5), &RA5PPS, PIN_MASK(RA5), &TRISA, &PORTA, NULL,    &LATA};
 
-const PinDef c_PIN_RC0 = {0b00010000, &RC0PPS, 0b00000001, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC1 = {0b00010001, &RC1PPS, 0b00000010, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC2 = {0b00010010, &RC2PPS, 0b00000100, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC3 = {0b00010011, &RC3PPS, 0b00001000, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC4 = {0b00010100, &RC4PPS, 0b00010000, &TRISC, &PORTC, NULL,    &LATC};
-const PinDef c_PIN_RC5 = {0b00010101, &RC5PPS, 0b00100000, &TRISC, &PORTC, NULL,    &LATC};
+const PinDef c_PIN_RC0 = {PIN_PPS(RC0), &RC0PPS, PIN_MASK(RC0), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC1 = {PIN_PPS(RC1), &RC1PPS, PIN_MASK(RC1), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC2 = {PIN_PPS(RC2), &RC2PPS, PIN_MASK(RC2), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC3 = {PIN_PPS(RC3), &RC3PPS, PIN_MASK(RC3), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC4 = {PIN_PPS(RC4), &RC4PPS, PIN_MASK(RC4), &TRISC, &PORTC, NULL,    &LATC};
+const PinDef c_PIN_RC5 = {PIN_PPS(RC5), &RC5PPS, PIN_MASK(RC5), &TRISC, &PORTC, NULL,    &LATC};
 
 
 const PinDef* PIN_RA0 = &c_PIN_RA0;
@@ -57,26 +57,26 @@ const PinDef* PIN_RC5 = &c_PIN_RC5;
 const PinDef* PIN_RC6 = NULL;
 const PinDef* PIN_RC7 = NULL;
 #elif defined(PIC16F1709) || defined(PIC16LF1709)
-const PinDef c_PIN_RA0 = {0b00000000, &RA0PPS, 0b00000001, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA1 = {0b00000001, &RA1PPS, 0b00000010, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA2 = {0b00000010, &RA2PPS, 0b00000100, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA3 = {0b00000011, NULL,    0b00001000, NULL,   &PORTA, NULL,    NULL};
-const PinDef c_PIN_RA4 = {0b00000100, &RA4PPS, 0b00010000, &TRISA, &PORTA, &ANSELA, &LATA};
-const PinDef c_PIN_RA5 = {0b00000101, &RA5PPS, 0b00100000, &TRISA, &PORTA, NULL,    &LATA};
-
-const PinDef c_PIN_RB4 = {0b00001100, &RB4PPS, 0b00010000, &TRISB, &PORTB, &ANSELB, &LATB};
-const PinDef c_PIN_RB5 = {0b00001101, &RB5PPS, 0b00100000, &TRISB, &PORTB, &ANSELB, &LATB};
-const PinDef c_PIN_RB6 = {0b00001110, &RB6PPS, 0b01000000, &TRISB, &PORTB, NULL,    &LATB};
-const PinDef c_PIN_RB7 = {0b00001111, &RB7PPS, 0b10000000, &TRISB, &PORTB, NULL,    &LATB};
-
-const PinDef c_PIN_RC0 = {0b00010000, &RC0PPS, 0b00000001, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC1 = {0b00010001, &RC1PPS, 0b00000010, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC2 = {0b00010010, &RC2PPS, 0b00000100, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC3 = {0b00010011, &RC3PPS, 0b00001000, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC4 = {0b00010100, &RC4PPS, 0b00010000, &TRISC, &PORTC, NULL,    &LATC};
-const PinDef c_PIN_RC5 = {0b00010101, &RC5PPS, 0b00100000, &TRISC, &PORTC, NULL,    &LATC};
-const PinDef c_PIN_RC6 = {0b00010110, &RC6PPS, 0b01000000, &TRISC, &PORTC, &ANSELC, &LATC};
-const PinDef c_PIN_RC7 = {0b00010111, &RC7PPS, 0b10000000, &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RA0 = {PIN_PPS(RA0), &RA0PPS, PIN_MASK(RA0), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA1 = {PIN_PPS(RA1), &RA1PPS, PIN_MASK(RA1), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA2 = {PIN_PPS(RA2), &RA2PPS, PIN_MASK(RA2), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA3 = {PIN_PPS(RA3), NULL,    PIN_MASK(RA3), NULL,   &PORTA, NULL,    NULL};
+const PinDef c_PIN_RA4 = {PIN_PPS(RA4), &RA4PPS, PIN_MASK(RA4), &TRISA, &PORTA, &ANSELA, &LATA};
+const PinDef c_PIN_RA5 = {PIN_PPS(RA5), &RA5PPS, PIN_MASK(RA5), &TRISA, &PORTA, NULL,    &LATA};
+
+const PinDef c_PIN_RB4 = {PIN_PPS(RB4), &RB4PPS, PIN_MASK(RB4), &TRISB, &PORTB, &ANSELB, &LATB};
+const PinDef c_PIN_RB5 = {PIN_PPS(RB5), &RB5PPS, PIN_MASK(RB5), &TRISB, &PORTB, &ANSELB, &LATB};
+const PinDef c_PIN_RB6 = {PIN_PPS(RB6), &RB6PPS, PIN_MASK(RB6), &TRISB, &PORTB, NULL,    &LATB};
+const PinDef c_PIN_RB7 = {PIN_PPS(RB7), &RB7PPS, PIN_MASK(RB7), &TRISB, &PORTB, NULL,    &LATB};
+
+const PinDef c_PIN_RC0 = {PIN_PPS(RC0), &RC0PPS, PIN_MASK(RC0), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC1 = {PIN_PPS(RC1), &RC1PPS, PIN_MASK(RC1), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC2 = {PIN_PPS(RC2), &RC2PPS, PIN_MASK(RC2), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC3 = {PIN_PPS(RC3), &RC3PPS, PIN_MASK(RC3), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC4 = {PIN_PPS(RC4), &RC4PPS, PIN_MASK(RC4), &TRISC, &PORTC, NULL,    &LATC};
+const PinDef c_PIN_RC5 = {PIN_PPS(RC5), &RC5PPS, PIN_MASK(RC5), &TRISC, &PORTC, NULL,    &LATC};
+const PinDef c_PIN_RC6 = {PIN_PPS(RC6), &RC6PPS, PIN_MASK(RC6), &TRISC, &PORTC, &ANSELC, &LATC};
+const PinDef c_PIN_RC7 = {PIN_PPS(RC7), &RC7PPS, PIN_MASK(RC7), &TRISC, &PORTC, &ANSELC, &LATC};
 
 
 const PinDef* PIN_RA0 = &c_PIN_RA0;
@@ -138,6 +138,14 @@ void pin_set_output(const PinDef* def, bool on) {
     }
 }
 
+void pin_set_output_source(const PinDef* def, uint8_t source) {
+    if (!def || !def->out_src_pps_reg) {
+        return;
+    }
+    
+    *(def->out_src_pps_reg) = source;
+}
+
 void pin_set_input_mode(const PinDef* def, uint8_t input_mode) {
     if (!def || !def->ansel_reg) {
         return;
@@ -150,3 +158,249 @@ void pin_set_input_mode(const PinDef* def, uint8_t input_mode) {
     }
 }
 
+
+/*
+ * PinId access. TRISx, LATx, PORTx and ANSELx of the ports A, B and C are
+ * consecutive registers, so the port index of a PinId selects the register
+ * relative to the one of port A.
+ */
+#define PIN_ID_PORT(id) ((uint8_t) ((id) >> 3))
+
+// Avoids a variable shift, which the core can only do in a loop
+const uint8_t pic170x_pin_id_masks[8] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+};
+
+// Implemented pins of each port. Ids of other pins would access 
+// unimplemented registers, they are rejected like PIN_ID_NONE.
+#if defined(PIC16F1709) || defined(PIC16LF1709)
+static const uint8_t c_pin_id_ports[PIN_GROUP_MAX_PORTS] = {0x3F, 0xF0, 0xFF};
+#else
+static const uint8_t c_pin_id_ports[PIN_GROUP_MAX_PORTS] = {0x3F, 0x00, 0x3F};
+#endif
+
+#define PIN_ID_VALID(id) (((id) < (PIN_GROUP_MAX_PORTS << 3)) \
+    && (c_pin_id_ports[PIN_ID_PORT(id)] & PIN_ID_MASK(id)))
+
+PinId pin_id(const PinDef* def) {
+    return def ? def->pin_pps : PIN_ID_NONE;
+}
+
+void pin_id_set_pin_mode(PinId id, bool output) {
+    volatile unsigned char* tris_reg;
+    
+    if (!PIN_ID_VALID(id)) {
+        return;
+    }
+    
+    tris_reg = &(&TRISA)[PIN_ID_PORT(id)];
+    if (output) {
+        *tris_reg = (uint8_t) (*tris_reg & (~PIN_ID_MASK(id)));
+    } else {
+        *tris_reg = (uint8_t) (*tris_reg | PIN_ID_MASK(id));
+    }
+}
+
+bool pin_id_get_input(PinId id) {
+    uint8_t port, mask;
+    
+    if (!PIN_ID_VALID(id)) {
+        return 0;
+    }
+    
+    port = PIN_ID_PORT(id);
+    mask = PIN_ID_MASK(id);
+    if (((&TRISA)[port] & mask) == 0) {
+        return ((&LATA)[port] & mask) != 0;
+    }
+    return ((&PORTA)[port] & mask) != 0;
+}
+
+void pin_id_set_output(PinId id, bool on) {
+    volatile unsigned char* latch_reg;
+    
+    if (!PIN_ID_VALID(id)) {
+        return;
+    }
+    
+    latch_reg = &(&LATA)[PIN_ID_PORT(id)];
+    if (on) {
+        *latch_reg = (uint8_t) (*latch_reg | PIN_ID_MASK(id));
+    } else {
+        *latch_reg = (uint8_t) (*latch_reg & (~PIN_ID_MASK(id)));
+    }
+}
+
+void pin_id_toggle_output(PinId id) {
+    volatile unsigned char* latch_reg;
+    
+    if (!PIN_ID_VALID(id)) {
+        return;
+    }
+    
+    latch_reg = &(&LATA)[PIN_ID_PORT(id)];
+    *latch_reg = (uint8_t) (*latch_reg ^ PIN_ID_MASK(id));
+}
+
+void pin_id_set_input_mode(PinId id, uint8_t input_mode) {
+    volatile unsigned char* ansel_reg;
+    
+    if (!PIN_ID_VALID(id)) {
+        return;
+    }
+    
+    // Pins without analog function have unimplemented ANSELx bits
+    ansel_reg = &(&ANSELA)[PIN_ID_PORT(id)];
+    if (input_mode == PIN_INPUT_MODE_DIGITAL) {
+        *ansel_reg = (uint8_t) (*ansel_reg & (~PIN_ID_MASK(id)));
+    } else {
+        *ansel_reg = (uint8_t) (*ansel_reg | PIN_ID_MASK(id));
+    }
+}
+
+
+void pin_group_init(PinGroup* group, const PinDef* const* pins, uint8_t count) {
+    uint8_t i, p;
+    
+    group->port_count = 0;
+    
+    for (i = 0; i < count; i++) {
+        const PinDef* def = pins[i];
+        if (!def || !def->port_reg) {
+            continue;
+        }
+        
+        PinGroupPort* port = NULL;
+        for (p = 0; p < group->port_count; p++) {
+            if (group->ports[p].port_reg == def->port_reg) {
+                port = &group->ports[p];
+                break;
+            }
+        }
+        if (!port) {
+            port = &group->ports[group->port_count++];
+            port->mask = 0;
+            port->tris_reg = NULL;
+            port->port_reg = def->port_reg;
+            port->latch_reg = NULL;
+        }
+        
+        // Input-only pins (RA3) have no tris or latch register, but share
+        // the port with pins that do.
+        if (def->tris_reg) port->tris_reg = def->tris_reg;
+        if (def->latch_reg) port->latch_reg = def->latch_reg;
+        port->mask |= def->pin_tris_bitmask;
+    }
+}
+
+void pin_group_init_ids(PinGroup* group, const PinId* ids, uint8_t count) {
+    uint8_t i, p, port_index;
+    
+    group->port_count = 0;
+    
+    for (i = 0; i < count; i++) {
+        if (!PIN_ID_VALID(ids[i])) {
+            continue;
+        }
+        port_index = PIN_ID_PORT(ids[i]);
+        
+        PinGroupPort* port = NULL;
+        for (p = 0; p < group->port_count; p++) {
+            if (group->ports[p].port_reg == &(&PORTA)[port_index]) {
+                port = &group->ports[p];
+                break;
+            }
+        }
+        if (!port) {
+            port = &group->ports[group->port_count++];
+            port->mask = 0;
+            port->tris_reg = &(&TRISA)[port_index];
+            port->port_reg = &(&PORTA)[port_index];
+            port->latch_reg = &(&LATA)[port_index];
+        }
+        port->mask |= PIN_ID_MASK(ids[i]);
+    }
+}
+
+void pin_group_set_pin_mode(const PinGroup* group, bool output) {
+    uint8_t p;
+    
+    for (p = 0; p < group->port_count; p++) {
+        const PinGroupPort* port = &group->ports[p];
+        if (!port->tris_reg) {
+            continue;
+        }
+        
+        if (output) {
+            *(port->tris_reg) = (uint8_t) (*(port->tris_reg) & (~port->mask));
+        } else {
+            *(port->tris_reg) = (uint8_t) (*(port->tris_reg) | port->mask);
+        }
+    }
+}
+
+void pin_group_set_outputs(const PinGroup* group, bool on) {
+    uint8_t p;
+    
+    for (p = 0; p < group->port_count; p++) {
+        const PinGroupPort* port = &group->ports[p];
+        if (!port->latch_reg) {
+            continue;
+        }
+        
+        if (on) {
+            *(port->latch_reg) = (uint8_t) (*(port->latch_reg) | port->mask);
+        } else {
+            *(port->latch_reg) = (uint8_t) (*(port->latch_reg) & (~port->mask));
+        }
+    }
+}
+
+void pin_group_toggle_outputs(const PinGroup* group) {
+    uint8_t p;
+    
+    for (p = 0; p < group->port_count; p++) {
+        const PinGroupPort* port = &group->ports[p];
+        if (!port->latch_reg) {
+            continue;
+        }
+        
+        *(port->latch_reg) = (uint8_t) (*(port->latch_reg) ^ port->mask);
+    }
+}
+
+void pin_group_write(const PinGroup* group, const uint8_t* values) {
+    uint8_t p;
+    
+    for (p = 0; p < group->port_count; p++) {
+        const PinGroupPort* port = &group->ports[p];
+        if (!port->latch_reg) {
+            continue;
+        }
+        
+        *(port->latch_reg) = (uint8_t) ((*(port->latch_reg) & (~port->mask)) | (values[p] & port->mask));
+    }
+}
+
+void pin_group_read(const PinGroup* group, uint8_t* values) {
+    uint8_t p;
+    
+    for (p = 0; p < group->port_count; p++) {
+        values[p] = (uint8_t) (*(group->ports[p].port_reg) & group->ports[p].mask);
+    }
+}
+
+bool pin_group_get_value(const PinGroup* group, const uint8_t* values, const PinDef* def) {
+    uint8_t p;
+    
+    if (!def) {
+        return 0;
+    }
+    
+    for (p = 0; p < group->port_count; p++) {
+        if (group->ports[p].port_reg == def->port_reg) {
+            return (values[p] & def->pin_tris_bitmask) != 0;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/ioc.h"
+#include "libpic170x/timer0.h"
+#include "libpic170x/ring_buffer.h"
+
+#include <xc.h>
+
+// IOCxP, IOCxN and IOCxF of each port are consecutive registers, PORTx
+// registers are consecutive as well. Both are indexed by pin_pps >> 3.
+#define IOC_REG_P(port) ((&IOCAP)[3 * (port)])
+#define IOC_REG_N(port) ((&IOCAN)[3 * (port)])
+#define IOC_REG_F(port) ((&IOCAF)[3 * (port)])
+
+#define PORT_COUNT 3
+#if defined(PIC16F1709) || defined(PIC16LF1709)
+  #define PORT_SKIP(port) 0
+#else
+  // The PIC16(L)F1705 has no PORTB
+  #define PORT_SKIP(port) ((port) == 1)
+#endif
+
+static IocEvent queue_storage[LIBPIC170X_IOC_QUEUE_SIZE];
+// Produced by ioc_ih(), consumed by ioc_read_events()
+static RingBuffer queue;
+static uint8_t dropped = 0;
+
+void ioc_init(void) {
+    bool gie = GIE;
+    
+    GIE = 0;
+    IOCAP = 0;
+    IOCAN = 0;
+    IOCAF = 0;
+#if defined(PIC16F1709) || defined(PIC16LF1709)
+    IOCBP = 0;
+    IOCBN = 0;
+    IOCBF = 0;
+#endif
+    IOCCP = 0;
+    IOCCN = 0;
+    IOCCF = 0;
+    
+    ring_buffer_init(&queue, queue_storage, LIBPIC170X_IOC_QUEUE_SIZE, sizeof(IocEvent));
+    dropped = 0;
+    IOCIE = 1;
+    if (gie) GIE = 1;
+}
+
+void ioc_enable(const PinDef* def, uint8_t edges) {
+    uint8_t port, mask;
+    bool gie;
+    
+    if (!def) {
+        return;
+    }
+    
+    port = def->pin_pps >> 3;
+    mask = def->pin_tris_bitmask;
+    
+    gie = GIE;
+    GIE = 0;
+    if (edges & IOC_EDGE_RISING) {
+        IOC_REG_P(port) |= mask;
+    } else {
+        IOC_REG_P(port) &= (uint8_t) ~mask;
+    }
+    if (edges & IOC_EDGE_FALLING) {
+        IOC_REG_N(port) |= mask;
+    } else {
+        IOC_REG_N(port) &= (uint8_t) ~mask;
+    }
+    IOC_REG_F(port) &= (uint8_t) ~mask;
+    if (gie) GIE = 1;
+}
+
+bool ioc_ih(void) {
+    uint8_t port, bit, flags, level, rising, falling;
+    IocEvent event;
+    
+    if (!IOCIF) {
+        return false;
+    }
+    
+    for (port = 0; port < PORT_COUNT; port++) {
+        if (PORT_SKIP(port)) {
+            continue;
+        }
+        
+        flags = IOC_REG_F(port);
+        if (!flags) {
+            continue;
+        }
+        // Only clear the flags that are processed here, so that edges
+        // arriving in the meantime raise the interrupt again.
+        IOC_REG_F(port) &= (uint8_t) ~flags;
+        
+        level = (&PORTA)[port];
+        rising = IOC_REG_P(port);
+        falling = IOC_REG_N(port);
+        
+        for (bit = 0; bit < 8; bit++) {
+            if (!(flags & (1u << bit))) {
+                continue;
+            }
+            
+            event.pin_pps = (uint8_t) ((port << 3) | bit);
+            if (!(falling & (1u << bit))) {
+                event.edge = IOC_EDGE_RISING;
+            } else if (!(rising & (1u << bit))) {
+                event.edge = IOC_EDGE_FALLING;
+            } else {
+                event.edge = (level & (1u << bit)) ? IOC_EDGE_RISING : IOC_EDGE_FALLING;
+            }
+            event.ms = pic170x_timer0.ms;
+            
+            if (!ring_buffer_push(&queue, &event) && (dropped != 0xFF)) {
+                dropped++;
+            }
+        }
+    }
+    
+    return true;
+}
+
+uint8_t ioc_read_events(IocEvent* events, uint8_t max) {
+    return ring_buffer_pop_bulk(&queue, events, max);
+}
+
+uint8_t ioc_dropped_events(void) {
+    return dropped;
+}
@@ -0,0 +1,199 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file adc.h
+ * \brief Continuous ADC scan engine with oversampling.
+ * 
+ * The adc library samples a list of analog pins in the background. 
+ * Conversions are started by the ADC auto-conversion trigger from a timer,
+ * so the sample rate is fixed by hardware. The interrupt handler adc_ih() 
+ * accumulates each result and switches to the next channel of the list, 
+ * which also gives the input the full trigger period as acquisition time.
+ * 
+ * Every channel is sampled 4^LIBPIC170X_ADC_OVERSAMPLE_BITS times per scan.
+ * The accumulated samples are decimated to 10 + LIBPIC170X_ADC_OVERSAMPLE_BITS
+ * bits and published in a double-buffered snapshot. adc_read() and adc_get()
+ * read the latest snapshot without disabling interrupts.
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     timer0_ih(NULL);
+ *     adc_ih();
+ *   }
+ * 
+ *   int main() {
+ *     const PinDef* inputs[] = {PIN_RA2, PIN_RC3};
+ *     uint16_t values[2];
+ *     // ...
+ *     timer0_init(NULL);
+ *     adc_scan_init(inputs, 2, ADC_TRIGGER_TIMER0);
+ *     GIE = 1;
+ *     while (true) {
+ *       adc_read(values);
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef ADC_H
+#define	ADC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "io_control.h"
+
+#ifndef LIBPIC170X_ADC_MAX_CHANNELS
+  //! Maximum number of channels in a scan list
+  #define LIBPIC170X_ADC_MAX_CHANNELS 8
+#endif
+
+#ifndef LIBPIC170X_ADC_OVERSAMPLE_BITS
+  //! Extra bits of resolution gained by oversampling (0 to 3)
+  #define LIBPIC170X_ADC_OVERSAMPLE_BITS 0
+#endif
+
+#if LIBPIC170X_ADC_OVERSAMPLE_BITS < 0 || LIBPIC170X_ADC_OVERSAMPLE_BITS > 3
+  #error "LIBPIC170X_ADC_OVERSAMPLE_BITS must be between 0 and 3"
+#endif
+
+// The library must be built with the same sizes (see freq.h)
+#define adc_scan_init_clock __LIBPIC170X_SIZE_TAG2(adc_scan_init_clock, LIBPIC170X_ADC_MAX_CHANNELS, LIBPIC170X_ADC_OVERSAMPLE_BITS)
+
+//! Samples per channel and scan
+#define ADC_OVERSAMPLE_COUNT (1u << (2 * LIBPIC170X_ADC_OVERSAMPLE_BITS))
+
+//! Largest value returned by adc_get()
+#define ADC_MAX_VALUE ((1u << (10 + LIBPIC170X_ADC_OVERSAMPLE_BITS)) - 1)
+
+//! Auto-conversion trigger: timer0 overflow, i.e. once per timer0 period
+#define ADC_TRIGGER_TIMER0 0x03
+//! Auto-conversion trigger: timer1 overflow
+#define ADC_TRIGGER_TIMER1 0x04
+//! Auto-conversion trigger: timer2 matches PR2
+#define ADC_TRIGGER_TIMER2 0x05
+
+//! ADC channel that is not connected to a pin
+#define ADC_CHANNEL_NONE 0xFF
+
+/*
+ * ADC conversion clock (ADCS bits), the fastest setting with a TAD of at 
+ * least 1 us.
+ */
+#ifndef _XTAL_FREQ
+  // Library build, the clock bits are passed to adc_scan_init_clock()
+#elif _XTAL_FREQ > 16000000
+  #define ADC_CLOCK_BITS 0x02   // Fosc/32
+#elif _XTAL_FREQ > 8000000
+  #define ADC_CLOCK_BITS 0x05   // Fosc/16
+#elif _XTAL_FREQ > 4000000
+  #define ADC_CLOCK_BITS 0x01   // Fosc/8
+#elif _XTAL_FREQ > 2000000
+  #define ADC_CLOCK_BITS 0x04   // Fosc/4
+#else
+  #define ADC_CLOCK_BITS 0x00   // Fosc/2
+#endif
+
+/**
+ * Returns the analog channel (ANx) of a pin.
+ * 
+ * @param def
+ *     The pin.
+ * @return
+ *     The channel number or ADC_CHANNEL_NONE if the pin has no analog
+ *     function.
+ */
+uint8_t adc_pin_channel(const PinDef* def);
+
+/**
+ * Configures the given pins as analog inputs and starts scanning them with
+ * the given conversion clock. Use adc_scan_init() instead, which selects the
+ * conversion clock for the configured _XTAL_FREQ.
+ * 
+ * @param pins
+ *     Pins to sample, in scan order.
+ * @param count
+ *     Number of pins, at most LIBPIC170X_ADC_MAX_CHANNELS.
+ * @param trigger
+ *     One of the ADC_TRIGGER_ values.
+ * @param clock_bits
+ *     ADCS bits of ADCON1, see ADC_CLOCK_BITS.
+ * @return
+ *     False if count is out of range or a pin has no analog channel.
+ */
+bool adc_scan_init_clock(const PinDef* const* pins, uint8_t count, uint8_t trigger, uint8_t clock_bits);
+
+#if defined(_XTAL_FREQ) || defined(__LIBPIC170X_DOXYGEN)
+/**
+ * Configures the given pins as analog inputs and starts scanning them. 
+ * Enables the ADC interrupt and PEIE, GIE must be enabled by the caller.
+ * The timer selected as trigger must be configured by the caller
+ * (timer0 by timer0_init()).
+ * 
+ * @param pins
+ *     Pins to sample, in scan order.
+ * @param count
+ *     Number of pins, at most LIBPIC170X_ADC_MAX_CHANNELS.
+ * @param trigger
+ *     One of the ADC_TRIGGER_ values.
+ * @return
+ *     False if count is out of range or a pin has no analog channel.
+ */
+static inline bool adc_scan_init(const PinDef* const* pins, uint8_t count, uint8_t trigger) {
+    return adc_scan_init_clock(pins, count, trigger, ADC_CLOCK_BITS);
+}
+#endif
+
+/**
+ * Stops scanning and switches the ADC off.
+ */
+void adc_scan_stop(void);
+
+/**
+ * Interrupt handler part. Accumulates the finished conversion and selects
+ * the next channel.
+ */
+void adc_ih(void);
+
+//! Interrupt dispatcher entry (see isr.h)
+#define ADC_ISR_ENTRY (ADIE && ADIF, adc_ih())
+
+/**
+ * Copies the latest snapshot of all channels, in scan order.
+ * 
+ * @param values
+ *     Buffer for one value per scanned pin.
+ * @return
+ *     Snapshot sequence number, incremented with every completed scan. 
+ *     Can be compared with a previous call to detect new data.
+ */
+uint8_t adc_read(uint16_t* values);
+
+/**
+ * Returns the latest value of a single channel from the snapshot.
+ * 
+ * @param index
+ *     Position of the pin in the scan list.
+ * @return
+ *     Value between 0 and ADC_MAX_VALUE, 0 before the first scan completed.
+ */
+uint16_t adc_get(uint8_t index);
+
+#endif	/* ADC_H */
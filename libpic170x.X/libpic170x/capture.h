@@ -0,0 +1,202 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file capture.h
+ * \brief Frequency and pulse width measurement with timer1 and CCP capture.
+ *
+ * The capture library measures external signals with the capture mode of
+ * the CCP1 and CCP2 modules. Timer1 runs freely from Fosc/4, and the CCP
+ * module copies its value into CCPRx on every selected edge of the input,
+ * so edges are timestamped by hardware. The interrupt handler capture_ih()
+ * extends the 16-bit captures with a timer1 overflow counter to 32-bit
+ * timestamps and derives periods, pulse widths and averages in the
+ * background.
+ *
+ * Inputs are routed through PPS, so any PinDef can be measured. CCP1 and
+ * CCP2 cannot be used for PWM (see pwm.h) while they capture.
+ *
+ * Times are given in timer1 ticks. CAPTURE_TICKS_PER_SECOND() converts the
+ * prescaler into the tick rate at _XTAL_FREQ, which capture_frequency()
+ * needs.
+ *
+ * Example:
+ *
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     capture_ih();
+ *   }
+ *
+ *   int main() {
+ *     CaptureResult result;
+ *     uint32_t mhz;
+ *
+ *     // ...
+ *     capture_init(CAPTURE_PRESCALE_8);
+ *     capture_enable(CAPTURE_CHANNEL_CCP1, PIN_RC3, CAPTURE_MODE_PULSE);
+ *     GIE = 1;
+ *     while (true) {
+ *       __delay_ms(500);
+ *       if (capture_read(CAPTURE_CHANNEL_CCP1, &result)) {
+ *         mhz = capture_frequency(&result, CAPTURE_TICKS_PER_SECOND(CAPTURE_PRESCALE_8));
+ *       }
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef CAPTURE_H
+#define	CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "io_control.h"
+
+//! Capture channel of the CCP1 module
+#define CAPTURE_CHANNEL_CCP1 0
+//! Capture channel of the CCP2 module
+#define CAPTURE_CHANNEL_CCP2 1
+//! Number of capture channels
+#define CAPTURE_CHANNEL_COUNT 2
+
+//! Timer1 prescaler 1:1
+#define CAPTURE_PRESCALE_1 0
+//! Timer1 prescaler 1:2
+#define CAPTURE_PRESCALE_2 1
+//! Timer1 prescaler 1:4
+#define CAPTURE_PRESCALE_4 2
+//! Timer1 prescaler 1:8
+#define CAPTURE_PRESCALE_8 3
+
+//! Captures every rising edge, measures the period
+#define CAPTURE_MODE_PERIOD 0
+//! Captures every 4th rising edge, for signals faster than the handler
+#define CAPTURE_MODE_PERIOD_4 1
+//! Captures every 16th rising edge, for signals faster than the handler
+#define CAPTURE_MODE_PERIOD_16 2
+//! Captures rising and falling edges, measures period and high time
+#define CAPTURE_MODE_PULSE 3
+
+#if defined(_XTAL_FREQ) || defined(__LIBPIC170X_DOXYGEN)
+  /**
+   * Timer1 ticks per second at _XTAL_FREQ for one of the CAPTURE_PRESCALE_
+   * values.
+   */
+  #define CAPTURE_TICKS_PER_SECOND(prescale) ((_XTAL_FREQ / 4ul) >> (prescale))
+#endif
+
+/**
+ * \struct CaptureResult
+ * Measurement of a channel, see capture_read(). All times are in timer1
+ * ticks.
+ */
+typedef struct {
+    //! Duration of the last complete period
+    uint32_t period;
+    //! High time of the last complete pulse (CAPTURE_MODE_PULSE only)
+    uint32_t high;
+    //! Time spanned by the periods counted in periods
+    uint32_t span;
+    //! Number of periods since the previous capture_read()
+    uint16_t periods;
+} CaptureResult;
+
+/**
+ * Configures and starts timer1 as the free-running time base of all
+ * channels and enables its overflow interrupt. Enables PEIE, GIE must be
+ * enabled by the caller.
+ *
+ * @param prescale
+ *     One of the CAPTURE_PRESCALE_ values. A larger prescaler gives more
+ *     time for slow signals between two timer1 overflows, but a lower
+ *     resolution.
+ */
+void capture_init(uint8_t prescale);
+
+/**
+ * Starts measuring on a channel. The pin is configured as digital input
+ * and routed to the CCP module. The PPS registers must not be locked.
+ *
+ * @param channel
+ *     One of the CAPTURE_CHANNEL_ values.
+ * @param pin
+ *     Input pin.
+ * @param mode
+ *     One of the CAPTURE_MODE_ values.
+ */
+void capture_enable(uint8_t channel, const PinDef* pin, uint8_t mode);
+
+/**
+ * Stops measuring on a channel and turns the CCP module off.
+ *
+ * @param channel
+ *     One of the CAPTURE_CHANNEL_ values.
+ */
+void capture_disable(uint8_t channel);
+
+/**
+ * Returns the latest measurement of a channel and restarts the averaging.
+ * period and high are kept until they are replaced by a newer measurement,
+ * span and periods cover the periods since the previous call.
+ *
+ * @param channel
+ *     One of the CAPTURE_CHANNEL_ values.
+ * @param result
+ *     Receives the measurement.
+ * @return
+ *     False if no period was completed since the previous call, e.g.
+ *     because the signal stopped. result is written in any case.
+ */
+bool capture_read(uint8_t channel, CaptureResult* result);
+
+/**
+ * Computes the average frequency from a measurement.
+ *
+ * @param result
+ *     Measurement from capture_read().
+ * @param ticks_per_second
+ *     Timer1 tick rate, see CAPTURE_TICKS_PER_SECOND().
+ * @return
+ *     Frequency in mHz, 0 if result contains no period. Frequencies must
+ *     be below 4.29 MHz.
+ */
+uint32_t capture_frequency(const CaptureResult* result, uint32_t ticks_per_second);
+
+/**
+ * Computes the duty cycle of the last pulse from a CAPTURE_MODE_PULSE
+ * measurement.
+ *
+ * @param result
+ *     Measurement from capture_read().
+ * @param max
+ *     Value for a duty cycle of 100 %, e.g. 1000 for 0.1 % steps.
+ * @return
+ *     Duty cycle between 0 and max, 0 if result contains no period.
+ */
+uint16_t capture_duty(const CaptureResult* result, uint16_t max);
+
+/**
+ * Interrupt handler part. Timestamps captured edges and counts timer1
+ * overflows.
+ */
+void capture_ih(void);
+
+//! Interrupt dispatcher entry (see isr.h)
+#define CAPTURE_ISR_ENTRY ((TMR1IE && TMR1IF) || (CCP1IE && CCP1IF) || (CCP2IE && CCP2IF), capture_ih())
+
+#endif	/* CAPTURE_H */
@@ -0,0 +1,146 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file clock.h
+ * \brief Switching the processor clock at runtime.
+ *
+ * The clock library changes the processor frequency between the supported
+ * frequencies of freq.h while the program runs, e.g. to run at 32 MHz while
+ * there is work to do and at 500 kHz while waiting. On every switch, the
+ * timer0 prescaler is selected such that the timer0 period stays the same,
+ * so the ms counter of timer0 and everything that counts timer0 ticks 
+ * (soft timers, debounce, ADC_TRIGGER_TIMER0) keep their timing. Switches 
+ * to frequencies at which the period cannot be kept are refused, see
+ * clock_set().
+ *
+ * _XTAL_FREQ is still the frequency the program starts with. Everything
+ * else that is derived from it at compile time is not adjusted: baud rates
+ * (EUSART_BRG()), SPI and I2C clocks, PWM_CONFIG(), the ADC conversion clock
+ * and the `__delay_ms()`/`__delay_us()` macros. Either reinitialize these
+ * peripherals after a switch or only switch while they are not in use.
+ *
+ * Example, built with `-DLIBPIC170X_TIMER0_PERIOD_US=4096`:
+ *
+ * \code{.c}
+ *   int main() {
+ *     OSCCON = OSCCON_BITS;
+ *     timer0_init(NULL);
+ *     GIE = 1;
+ *     while (true) {
+ *       clock_set(NULL, CLOCK_32MHZ);
+ *       do_work();
+ *       clock_set(NULL, CLOCK_500KHZ);
+ *       wait_for_next_event();
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef CLOCK_H
+#define	CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "timer0.h"
+
+//! 500 kHz (MFINTOSC)
+#define CLOCK_500KHZ 0
+//! 1 MHz
+#define CLOCK_1MHZ 1
+//! 2 MHz
+#define CLOCK_2MHZ 2
+//! 4 MHz
+#define CLOCK_4MHZ 3
+//! 8 MHz
+#define CLOCK_8MHZ 4
+//! 16 MHz
+#define CLOCK_16MHZ 5
+//! 32 MHz (8 MHz HFINTOSC with 4x PLL)
+#define CLOCK_32MHZ 6
+//! Returned by clock_get() if OSCCON does not select a supported frequency
+#define CLOCK_UNKNOWN 0xFF
+
+//! Frequency in Hz of one of the CLOCK_ values
+#define CLOCK_FREQUENCY(clock) (500000ul << (clock))
+
+#if defined(_XTAL_FREQ) || defined(__LIBPIC170X_DOXYGEN)
+  //! CLOCK_ value of _XTAL_FREQ
+  #define CLOCK_XTAL_FREQ __LIBPIC170X_XTAL_SHIFT
+#endif
+
+/**
+ * Returns the current processor frequency, decoded from OSCCON. The 32 MHz
+ * PLL is only detected if it was enabled through SPLLEN (as OSCCON_BITS
+ * and clock_set() do), not through the PLLEN configuration bit.
+ *
+ * @return
+ *     One of the CLOCK_ values or CLOCK_UNKNOWN.
+ */
+uint8_t clock_get(void);
+
+/**
+ * Computes the timer0 settings for a frequency. freq.h performs the same
+ * computation at compile time for _XTAL_FREQ, the results match 
+ * TIMER0_CLOCK_INIT.
+ *
+ * @param settings
+ *     Receives the settings.
+ * @param clock
+ *     One of the CLOCK_ values.
+ * @param period_us
+ *     Targeted interrupt period, see LIBPIC170X_TIMER0_PERIOD_US.
+ * @param exact
+ *     True to reload TMR0 for an exact period, see
+ *     LIBPIC170X_TIMER0_EXACT_PERIOD.
+ * @return
+ *     False if the period cannot be reached at this frequency, or if an
+ *     exact period would require the prescaler.
+ */
+bool clock_timer0_settings(Timer0Clock* settings, uint8_t clock, uint32_t period_us, bool exact);
+
+/**
+ * Switches the processor clock and selects the timer0 prescaler that keeps
+ * the timer0 period. timer0 must have been initialized with timer0_init().
+ *
+ * The timer0 period (TIMER0_PERIOD_US) is a compile-time constant that
+ * soft timer ticks, debounce times and the ADC_TRIGGER_TIMER0 sample rate
+ * are derived from, so a switch that would change the period or the TMR0
+ * preload is refused. Select a LIBPIC170X_TIMER0_PERIOD_US that all used
+ * frequencies reach, e.g. 2048, 4096 or 8192 us in the free-running mode.
+ *
+ * Interrupts are disabled during the switch, which includes waiting for the
+ * new oscillator to become stable. The part of the current timer0 period
+ * that elapsed at the old frequency is added to the counter and a new
+ * period is started, which loses less than one TMR0 increment (see
+ * TIMER0_TICK_US_SHIFT) per switch.
+ *
+ * @param timer0
+ *
+ * The structure that is kept up to date. If NULL this defaults to
+ * pic170x_timer0.
+ *
+ * @param clock
+ *     One of the CLOCK_ values.
+ * @return
+ *     False if clock is invalid or the timer0 period cannot be kept at this
+ *     frequency. The clock is not changed in this case.
+ */
+bool clock_set(Timer0* timer0, uint8_t clock);
+
+#endif	/* CLOCK_H */
@@ -0,0 +1,141 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file debounce.h
+ * \brief Debounced pin states sampled on the timer0 tick.
+ * 
+ * The debounce library filters bouncing inputs like buttons and switches.
+ * debounce_tick() samples the complete PORTx registers once per timer0 
+ * interrupt. A pin only changes its debounced state after 
+ * DEBOUNCE_SAMPLES consecutive samples differed from it. The sample 
+ * counters are kept as vertical counters: bit n of two counter bytes per 
+ * port forms the 2-bit counter of pin n, so all 8 pins of a port are 
+ * filtered with a few logic instructions. The cost per tick does not 
+ * depend on the number of inputs.
+ * 
+ * Debounced state changes are collected in rising and falling edge masks
+ * per port, which the main loop reads and clears with debounce_rising() and
+ * debounce_falling(). For buttons that pull the pin low, a press is a 
+ * falling edge and a release a rising edge.
+ * 
+ * The debounce time is DEBOUNCE_SAMPLES timer0 periods, select
+ * `LIBPIC170X_TIMER0_PERIOD_US` accordingly (see freq.h), e.g. 4096 for
+ * about 16 ms.
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     if (timer0_ih(NULL)) {
+ *       debounce_tick();
+ *     }
+ *   }
+ * 
+ *   int main() {
+ *     // ...
+ *     pin_set_pin_mode(PIN_RA2, false);
+ *     pin_set_input_mode(PIN_RA2, PIN_INPUT_MODE_DIGITAL);
+ *     debounce_init();
+ *     GIE = 1;
+ *     while (true) {
+ *       if (debounce_falling(DEBOUNCE_PORT_A, PIN_MASK(RA2))) {
+ *         // button on RA2 pressed
+ *       }
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef DEBOUNCE_H
+#define	DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "io_control.h"
+
+//! Consecutive samples required to change the debounced state of a pin
+#define DEBOUNCE_SAMPLES 4
+
+//! Port index of PORTA
+#define DEBOUNCE_PORT_A 0
+//! Port index of PORTB (PIC16(L)F1709 only)
+#define DEBOUNCE_PORT_B 1
+//! Port index of PORTC
+#define DEBOUNCE_PORT_C 2
+
+/**
+ * Samples all ports and takes the values as debounced state without 
+ * reporting edges. Pins have to be configured as digital inputs by the
+ * caller.
+ */
+void debounce_init(void);
+
+/**
+ * Interrupt handler part. Samples all ports and updates the debounced 
+ * states and edge masks. Must be called periodically, usually whenever
+ * timer0_ih() returns true.
+ */
+void debounce_tick(void);
+
+/**
+ * Returns the debounced state of all pins of a port.
+ * 
+ * @param port
+ *     One of the DEBOUNCE_PORT_ values.
+ * @return
+ *     Debounced pin levels in the layout of the PORTx register.
+ */
+uint8_t debounce_state(uint8_t port);
+
+/**
+ * Returns the debounced state of a single pin.
+ * 
+ * @param id
+ *     The pin.
+ * @return
+ *     True if the debounced level is high, false for PIN_ID_NONE.
+ */
+bool debounce_get(PinId id);
+
+/**
+ * Returns and clears the debounced low-to-high transitions of the given
+ * pins since the last call.
+ * 
+ * @param port
+ *     One of the DEBOUNCE_PORT_ values.
+ * @param mask
+ *     Pins to check, e.g. `PIN_MASK(RA2)`. Other edges are kept.
+ * @return
+ *     The pins of mask that had a rising edge.
+ */
+uint8_t debounce_rising(uint8_t port, uint8_t mask);
+
+/**
+ * Returns and clears the debounced high-to-low transitions of the given
+ * pins since the last call.
+ * 
+ * @param port
+ *     One of the DEBOUNCE_PORT_ values.
+ * @param mask
+ *     Pins to check, e.g. `PIN_MASK(RA2)`. Other edges are kept.
+ * @return
+ *     The pins of mask that had a falling edge.
+ */
+uint8_t debounce_falling(uint8_t port, uint8_t mask);
+
+#endif	/* DEBOUNCE_H */
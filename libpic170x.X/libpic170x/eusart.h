@@ -0,0 +1,167 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file eusart.h
+ * \brief Interrupt-driven asynchronous serial port (EUSART).
+ * 
+ * The eusart library operates the EUSART of the PIC as an asynchronous
+ * 8N1 serial port. TX and RX are routed to any PPS-capable pin given as 
+ * `PinDef`. Data is moved between the application and the EUSART by the
+ * interrupt handler eusart_ih() through a transmit and a receive ring buffer
+ * (see ring_buffer.h), so neither eusart_write() nor eusart_read() ever wait
+ * for the hardware.
+ * 
+ * The baud rate divisor is computed at compile time from _XTAL_FREQ with
+ * EUSART_BRG(). The 16-bit baud rate generator is used in high speed mode,
+ * which covers 300 baud up to 2 MBaud at 32 MHz.
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     eusart_ih();
+ *   }
+ * 
+ *   int main() {
+ *     uint8_t buffer[8];
+ *     uint8_t n;
+ *     // ...
+ *     eusart_init(EUSART_BRG(115200), PIN_RC4, PIN_RC5);
+ *     GIE = 1;
+ *     eusart_write_string("hello\r\n");
+ *     while (true) {
+ *       n = eusart_read(buffer, sizeof(buffer));
+ *       eusart_write(buffer, n);    // echo
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef EUSART_H
+#define	EUSART_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "io_control.h"
+
+#ifndef LIBPIC170X_EUSART_TX_BUFFER_SIZE
+  //! Size of the transmit buffer in bytes (power of two, at most 128)
+  #define LIBPIC170X_EUSART_TX_BUFFER_SIZE 16
+#endif
+
+#ifndef LIBPIC170X_EUSART_RX_BUFFER_SIZE
+  //! Size of the receive buffer in bytes (power of two, at most 128)
+  #define LIBPIC170X_EUSART_RX_BUFFER_SIZE 16
+#endif
+
+// The library must be built with the same sizes (see freq.h)
+#define eusart_init __LIBPIC170X_SIZE_TAG2(eusart_init, LIBPIC170X_EUSART_TX_BUFFER_SIZE, LIBPIC170X_EUSART_RX_BUFFER_SIZE)
+
+/**
+ * Baud rate generator value (SP1BRG) for the given baud rate at _XTAL_FREQ, 
+ * rounded to the nearest value. Intended for constant arguments.
+ */
+#define EUSART_BRG(baud) \
+    ((uint16_t) ((_XTAL_FREQ + 2ul * (baud)) / (4ul * (baud)) - 1))
+
+/**
+ * Baud rate that actually results from EUSART_BRG(baud). Can be used to 
+ * check the baud rate error at compile time.
+ */
+#define EUSART_ACTUAL_BAUD(baud) (_XTAL_FREQ / (4ul * (EUSART_BRG(baud) + 1ul)))
+
+/**
+ * Configures the EUSART for asynchronous 8N1 operation, routes TX and RX to
+ * the given pins and enables the receive interrupt. PEIE is enabled, GIE must
+ * be enabled by the caller. The PPS registers must not be locked.
+ * 
+ * @param brg
+ *     Baud rate generator value, see EUSART_BRG().
+ * @param tx_pin
+ *     Pin that is used as TX output, or NULL if only receiving.
+ * @param rx_pin
+ *     Pin that is used as RX input, or NULL if only transmitting.
+ */
+void eusart_init(uint16_t brg, const PinDef* tx_pin, const PinDef* rx_pin);
+
+/**
+ * Interrupt handler part. Moves received bytes into the receive buffer and 
+ * bytes from the transmit buffer into the EUSART.
+ */
+void eusart_ih(void);
+
+//! Interrupt dispatcher entry (see isr.h)
+#define EUSART_ISR_ENTRY (RCIF || (TXIE && TXIF), eusart_ih())
+
+/**
+ * Queues bytes for transmission. Returns immediately, bytes that do not fit
+ * into the transmit buffer are not queued.
+ * 
+ * @param data
+ *     Bytes to send.
+ * @param length
+ *     Number of bytes to send.
+ * @return
+ *     Number of bytes that were queued.
+ */
+uint8_t eusart_write(const uint8_t* data, uint8_t length);
+
+/**
+ * Queues a zero-terminated string for transmission, see eusart_write().
+ * 
+ * @return
+ *     Number of characters that were queued.
+ */
+uint8_t eusart_write_string(const char* str);
+
+/**
+ * Returns the number of bytes that can currently be queued by eusart_write().
+ */
+uint8_t eusart_write_space(void);
+
+/**
+ * Checks if all queued bytes have been shifted out completely.
+ */
+bool eusart_tx_idle(void);
+
+/**
+ * Reads received bytes. Returns immediately.
+ * 
+ * @param data
+ *     Buffer for at least max bytes.
+ * @param max
+ *     Maximum number of bytes to read.
+ * @return
+ *     Number of bytes that were read.
+ */
+uint8_t eusart_read(uint8_t* data, uint8_t max);
+
+/**
+ * Returns the number of received bytes that are waiting to be read.
+ */
+uint8_t eusart_read_count(void);
+
+/**
+ * Returns the number of received bytes that were lost since eusart_init() 
+ * because the receive buffer was full or the hardware overran. The counter
+ * saturates at 255.
+ */
+uint8_t eusart_rx_dropped(void);
+
+#endif	/* EUSART_H */
@@ -20,10 +20,10 @@
  * 
  * 
  * This file defines important timing preprocessor variables that are used 
- * throughout all library components. All libraries are based on the 
- * assumption that the processor clock frequency the PIC microcontroller 
- * operates on does not change over time. It should be set once at the start
- * of the program never be touched again.
+ * throughout all library components. The processor clock frequency should
+ * be set once at the start of the program. Only timer0 follows later 
+ * changes made through clock.h, all other values derived from _XTAL_FREQ 
+ * assume that the frequency does not change.
  * 
  * The frequencies are set via the OSCCON bits of the PIC microcontroller.
  * freq.h derivs the correct OSCCON-bits from the defined _XTAL_FREQ. _XTAL_FREQ
@@ -44,6 +44,39 @@
  * Lower frequencies are not supported because the core library timer0 would 
  * become unusable due to huge counter steps.
  * 
+ * Timer0 period
+ * 
+ * The interrupt period of timer0 is selected at build time through
+ * `LIBPIC170X_TIMER0_PERIOD_US` (default: 131072). By default timer0 runs
+ * freely and freq.h selects the prescaler that results in the longest period
+ * that does not exceed the target, e.g. 8.192 ms for a target of 10000 us.
+ * Free-running periods never drift. If `LIBPIC170X_TIMER0_EXACT_PERIOD` is
+ * defined as well, TMR0 is reloaded on every interrupt so that the period
+ * matches the target exactly (see the [timer0 guide](@ref timer0-guide)).
+ * A TMR0 write clears the prescaler, so this is only drift-free, and only
+ * allowed, for periods that need no prescaler: at most 256 instruction 
+ * cycles at 4 MHz and below. Unreachable targets result in a compile-time
+ * error. The derived values are
+ * exposed as `TIMER0_PERIOD_US`, `TIMER0_MS_INC`, `TIMER0_US_INC`,
+ * `TIMER0_PRESCALE_BITS`, `TIMER0_PRELOAD` and `TIMER0_TICK_US_SHIFT`.
+ * 
+ * Static library
+ * 
+ * All values derived from _XTAL_FREQ are only evaluated in the headers, i.e.
+ * in the application's translation units. Time-critical code that depends on
+ * them, like timer0_ih(), is defined in the headers as well. Library 
+ * functions receive them as arguments or from RAM (see TIMER0_CLOCK_INIT),
+ * so one static library per chip serves all frequencies and timer0 periods. The
+ * library itself is built without _XTAL_FREQ (`__LIBPIC170X_LIBRARY_BUILD`).
+ * 
+ * Buffer and table sizes, like `LIBPIC170X_SOFT_TIMER_COUNT` or 
+ * `LIBPIC170X_EUSART_RX_BUFFER_SIZE`, are compiled into the library. Their
+ * values are part of the name of the module's init function (see
+ * __LIBPIC170X_SIZE_TAG()), so an application that sets other values than
+ * the library fails to link instead of overrunning the library's buffers.
+ * Pass the same settings to the library build (`size_opts` in the Makefile)
+ * and to the application, as plain decimal numbers.
+ * 
  * OSCCAL_BITS
  * 
  * One of the core-featues of `freq.h` is that is exposes the OSCCON bits that 
@@ -69,61 +102,73 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <string.h>
 
-#ifndef _XTAL_FREQ 
+#if !defined(_XTAL_FREQ) && !defined(__LIBPIC170X_LIBRARY_BUILD)
 #error "_XTAL_FREQ must be set to a valid value"
 #endif
 
 #ifdef __LIBPIC170X_DOXYGEN
   //! OSCCON bits that can derived from the set _XTAL_FREQ that the OSCCON register can be initailized with.
   #define OSCCON_BITS 0
-  //! Processor name internally used by libpic170x_check_library_build_arguments()
-  #define __LIBPIC170X_DEVICE_NAME "PIC16LF1705"
+  /**
+   * Appends the chip name to a symbol name, e.g. 
+   * `__LIBPIC170X_CHIP_TAG(foo)` becomes `foo_16LF1705`.
+   */
+  #define __LIBPIC170X_CHIP_TAG(name) name##_16LF1705
+  /**
+   * Defined while the static library is built. The library sources do not
+   * depend on _XTAL_FREQ, so it is left undefined.
+   */
+  #define __LIBPIC170X_LIBRARY_BUILD
+  /**
+   * Optional build-time setting: targeted timer0 interrupt period in us.
+   * Defaults to 131072, which selects the largest prescaler that keeps the
+   * period at or below ~131 ms.
+   */
+  #define LIBPIC170X_TIMER0_PERIOD_US 131072
+  /**
+   * Optional build-time setting: if defined, timer0_ih() reloads TMR0 so that
+   * the interrupt period is exactly LIBPIC170X_TIMER0_PERIOD_US. Requires a
+   * period that TMR0 reaches without prescaler.
+   */
+  #define LIBPIC170X_TIMER0_EXACT_PERIOD
+  //! Actual timer0 interrupt period in us
+  #define TIMER0_PERIOD_US 131072
+  //! ms portion of TIMER0_PERIOD_US
+  #define TIMER0_MS_INC 131
+  //! us portion of TIMER0_PERIOD_US
+  #define TIMER0_US_INC 72
+  //! OPTION_REG bits (PSA and PS) selecting the timer0 prescaler
+  #define TIMER0_PRESCALE_BITS 0x07
+  //! log2 of the microseconds between two TMR0 increments (prescaler included)
+  #define TIMER0_TICK_US_SHIFT 0
+  //! TMR0 value at the start of each period (0 if TMR0 is not reloaded)
+  #define TIMER0_PRELOAD 0
 #endif
 
+#ifdef _XTAL_FREQ
+
 #if _XTAL_FREQ == 32000000
   #define OSCCON_BITS 0b11110010
-
-  #define TIMER0_MS_INC 8
-  #define TIMER0_US_INC 192
-  #define TIMER0_PRESCALE_BITS 0x07
+  #define __LIBPIC170X_XTAL_SHIFT 6
 #elif _XTAL_FREQ == 16000000
   #define OSCCON_BITS 0b01111010
-
-  #define TIMER0_MS_INC 16
-  #define TIMER0_US_INC 384
-  #define TIMER0_PRESCALE_BITS 0x07
+  #define __LIBPIC170X_XTAL_SHIFT 5
 #elif _XTAL_FREQ == 8000000
   #define OSCCON_BITS 0b01110010
-
-  #define TIMER0_MS_INC 32
-  #define TIMER0_US_INC 768
-  #define TIMER0_PRESCALE_BITS 0x07
+  #define __LIBPIC170X_XTAL_SHIFT 4
 #elif _XTAL_FREQ == 4000000
   #define OSCCON_BITS 0b01101010
-
-  #define TIMER0_MS_INC 65
-  #define TIMER0_US_INC 536
-  #define TIMER0_PRESCALE_BITS 0x07
+  #define __LIBPIC170X_XTAL_SHIFT 3
 #elif _XTAL_FREQ == 2000000
   #define OSCCON_BITS 0b01100010
-
-  #define TIMER0_MS_INC 131
-  #define TIMER0_US_INC 072
-  #define TIMER0_PRESCALE_BITS 0x07
+  #define __LIBPIC170X_XTAL_SHIFT 2
 #elif _XTAL_FREQ == 1000000
   #define OSCCON_BITS 0b01011010
-
-  #define TIMER0_MS_INC 131
-  #define TIMER0_US_INC 072
-  #define TIMER0_PRESCALE_BITS 0x06
+  #define __LIBPIC170X_XTAL_SHIFT 1
 #elif _XTAL_FREQ == 500000
   #define OSCCON_BITS 0b00111010
-
-  #define TIMER0_MS_INC 131
-  #define TIMER0_US_INC 072
-  #define TIMER0_PRESCALE_BITS 0x05
+  #define __LIBPIC170X_XTAL_SHIFT 0
 #else
   #if _XTAL_FREQ < 500000
     #error "Invalid frequency (frequencies < 500kHz not supported)"
@@ -132,43 +177,173 @@
   #endif
 #endif
 
+/*
+ * Timer0 configuration
+ * 
+ * All supported frequencies are 500 kHz << __LIBPIC170X_XTAL_SHIFT, so an
+ * instruction cycle takes 8 >> __LIBPIC170X_XTAL_SHIFT us and every prescaler
+ * setting results in a power-of-two number of microseconds per TMR0 increment
+ * (2^TIMER0_TICK_US_SHIFT). The valid shifts are bounded by the prescaler
+ * range (1:1 to 1:256) and by the requirement that a TMR0 increment takes at
+ * least 1 us.
+ */
+#ifndef LIBPIC170X_TIMER0_PERIOD_US
+  #define LIBPIC170X_TIMER0_PERIOD_US 131072
+#endif
+
+#if __LIBPIC170X_XTAL_SHIFT >= 3
+  #define __LIBPIC170X_TIMER0_SHIFT_MIN 0
+#else
+  #define __LIBPIC170X_TIMER0_SHIFT_MIN (3 - __LIBPIC170X_XTAL_SHIFT)
+#endif
+#define __LIBPIC170X_TIMER0_SHIFT_MAX (11 - __LIBPIC170X_XTAL_SHIFT)
+
+#ifdef LIBPIC170X_TIMER0_EXACT_PERIOD
+  // Smallest shift for which the period fits into the 8-bit counter
+  #if 0 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 0) <= 256
+    #define TIMER0_TICK_US_SHIFT 0
+  #elif 1 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 1) <= 256
+    #define TIMER0_TICK_US_SHIFT 1
+  #elif 2 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 2) <= 256
+    #define TIMER0_TICK_US_SHIFT 2
+  #elif 3 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 3) <= 256
+    #define TIMER0_TICK_US_SHIFT 3
+  #elif 4 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 4) <= 256
+    #define TIMER0_TICK_US_SHIFT 4
+  #elif 5 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 5) <= 256
+    #define TIMER0_TICK_US_SHIFT 5
+  #elif 6 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 6) <= 256
+    #define TIMER0_TICK_US_SHIFT 6
+  #elif 7 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 7) <= 256
+    #define TIMER0_TICK_US_SHIFT 7
+  #elif 8 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 8) <= 256
+    #define TIMER0_TICK_US_SHIFT 8
+  #elif 9 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 9) <= 256
+    #define TIMER0_TICK_US_SHIFT 9
+  #elif 10 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 10) <= 256
+    #define TIMER0_TICK_US_SHIFT 10
+  #elif 11 >= __LIBPIC170X_TIMER0_SHIFT_MIN && (LIBPIC170X_TIMER0_PERIOD_US >> 11) <= 256
+    #define TIMER0_TICK_US_SHIFT 11
+  #endif
+  #if !defined(TIMER0_TICK_US_SHIFT) || TIMER0_TICK_US_SHIFT > __LIBPIC170X_TIMER0_SHIFT_MAX
+    #error "LIBPIC170X_TIMER0_PERIOD_US is too long for this _XTAL_FREQ"
+  #endif
+  #if (LIBPIC170X_TIMER0_PERIOD_US & ((1l << TIMER0_TICK_US_SHIFT) - 1)) != 0
+    #error "LIBPIC170X_TIMER0_PERIOD_US cannot be reached exactly at this _XTAL_FREQ"
+  #endif
+
+  #define TIMER0_PERIOD_US (LIBPIC170X_TIMER0_PERIOD_US + 0ul)
+  #define TIMER0_PRELOAD (256 - (LIBPIC170X_TIMER0_PERIOD_US >> TIMER0_TICK_US_SHIFT))
+#else
+  // Largest shift for which a full 8-bit counter period does not exceed the target
+  #if 11 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 11) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 11
+  #elif 10 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 10) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 10
+  #elif 9 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 9) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 9
+  #elif 8 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 8) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 8
+  #elif 7 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 7) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 7
+  #elif 6 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 6) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 6
+  #elif 5 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 5) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 5
+  #elif 4 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 4) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 4
+  #elif 3 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 3) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 3
+  #elif 2 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 2) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 2
+  #elif 1 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 1) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 1
+  #elif 0 <= __LIBPIC170X_TIMER0_SHIFT_MAX && (256l << 0) <= LIBPIC170X_TIMER0_PERIOD_US
+    #define TIMER0_TICK_US_SHIFT 0
+  #endif
+  #if !defined(TIMER0_TICK_US_SHIFT) || TIMER0_TICK_US_SHIFT < __LIBPIC170X_TIMER0_SHIFT_MIN
+    #error "LIBPIC170X_TIMER0_PERIOD_US is too short for this _XTAL_FREQ"
+  #endif
+
+  #define TIMER0_PERIOD_US (256ul << TIMER0_TICK_US_SHIFT)
+  #define TIMER0_PRELOAD 0
+#endif
+
+#define __LIBPIC170X_TIMER0_PRESCALE_LOG2 (TIMER0_TICK_US_SHIFT + __LIBPIC170X_XTAL_SHIFT - 3)
+#if __LIBPIC170X_TIMER0_PRESCALE_LOG2 == 0
+  // PSA set: prescaler not assigned to timer0
+  #define TIMER0_PRESCALE_BITS 0x08
+  // A TMR0 write inhibits the next two increments
+  #define __LIBPIC170X_TIMER0_RELOAD_COMPENSATION 2
+#else
+  #define TIMER0_PRESCALE_BITS (__LIBPIC170X_TIMER0_PRESCALE_LOG2 - 1)
+  #define __LIBPIC170X_TIMER0_RELOAD_COMPENSATION 0
+  #ifdef LIBPIC170X_TIMER0_EXACT_PERIOD
+    // A TMR0 write clears the prescaler, every reload would stretch the
+    // period by up to one prescaler step
+    #error "LIBPIC170X_TIMER0_EXACT_PERIOD requires a period of at most 256 instruction cycles (no prescaler), use the free-running mode"
+  #endif
+#endif
+
+#define TIMER0_MS_INC (TIMER0_PERIOD_US / 1000)
+#define TIMER0_US_INC (TIMER0_PERIOD_US % 1000)
+
+/*
+ * Carry threshold for the us portion of the timer0 counter. If the us counter
+ * is >= TIMER0_US_CARRY before an update, adding TIMER0_US_INC carries one
+ * millisecond. This lets timer0_ih() normalize the counter with a single
+ * compare and subtract instead of a division.
+ */
+#define TIMER0_US_CARRY (1000 - TIMER0_US_INC)
+
+#endif /* _XTAL_FREQ */
+
 #ifdef _16LF1705
-  #define __LIBPIC170X_DEVICE_NAME "PIC16LF1705"
+  #define __LIBPIC170X_CHIP_TAG(name) name##_16LF1705
 #elif _16F1705
-  #define __LIBPIC170X_DEVICE_NAME "PIC16F1705"
+  #define __LIBPIC170X_CHIP_TAG(name) name##_16F1705
 #elif _16LF1709
-  #define __LIBPIC170X_DEVICE_NAME "PIC16ÖF1709"
+  #define __LIBPIC170X_CHIP_TAG(name) name##_16LF1709
 #elif _16F1709
-  #define __LIBPIC170X_DEVICE_NAME "PIC16F1709"
+  #define __LIBPIC170X_CHIP_TAG(name) name##_16F1709
 #else
   #error "Unsupported chip"
 #endif
 
-//! Stores the _XTAL_FREQ that was used while building the static libpic170x library
-extern const uint32_t __LIBPIC170X_BUILT_XTAL_FREQ;
-//! Stores the device name (as string) used to build the static libpic170x library
-extern const char* __LIBPIC170X_BUILT_DEVICE_NAME;
+/*
+ * Appends the values of one or two size settings to a symbol name, e.g.
+ * `__LIBPIC170X_SIZE_TAG2(soft_timer_init, 16, 8)` becomes
+ * `soft_timer_init_16_8`. The settings must expand to plain decimal
+ * numbers, `16` and `0x10` result in different names.
+ */
+#define __LIBPIC170X_SIZE_TAG(name, a) __LIBPIC170X_SIZE_TAG_(name, a)
+#define __LIBPIC170X_SIZE_TAG_(name, a) name##_##a
+#define __LIBPIC170X_SIZE_TAG2(name, a, b) __LIBPIC170X_SIZE_TAG2_(name, a, b)
+#define __LIBPIC170X_SIZE_TAG2_(name, a, b) name##_##a##_##b
+
+/**
+ * Defined by the static library. The chip the library was built for is part 
+ * of the symbol name, so referencing it from a project for another chip 
+ * fails to link.
+ */
+extern const uint8_t __LIBPIC170X_CHIP_TAG(__libpic170x_built_for);
 
 /**
  * \brief Verify matching configuration parameters between main project and static library
  * 
- * This functions allows one to check if the arguments used while building the
- * library are matching the build arguments for the current project. Generally,
- * this should not be required, but it can be handy for sanity checks. It is
- * advisable to include a call to this function at the start of any program and
- * exit to a safe fail-state when the function returns false since the behavior
- * of libpic170x is undefined if the build arguments do not match between
- * a libpic170x static library and main application.
+ * The static library does not depend on _XTAL_FREQ or on the timer0 period
+ * settings, these are passed in from the headers when the library is 
+ * initialized (see timer0_init()). Only the chip has to match. The check
+ * happens at link time: this function references a symbol whose name
+ * contains the chip, linking a library that was built for another chip 
+ * fails with an undefined symbol. timer0_init() references a chip tagged
+ * symbol as well, so calling this function is optional.
  * 
  * @return 
- *     Returns true in case the build arguments are matching. If the function
- *     returns false, exit to a safe fail-state.
+ *     Always true, the function is kept for compatibility.
  */
-static bool libpic170x_check_library_build_arguments() {
-    return 
-        (strcmp(__LIBPIC170X_BUILT_DEVICE_NAME, __LIBPIC170X_DEVICE_NAME) == 0)
-        && (__LIBPIC170X_BUILT_XTAL_FREQ == _XTAL_FREQ);
+static inline bool libpic170x_check_library_build_arguments(void) {
+    return __LIBPIC170X_CHIP_TAG(__libpic170x_built_for) != 0;
 }
 
 #endif	/* FREQ_H */
-
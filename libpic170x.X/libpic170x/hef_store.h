@@ -0,0 +1,141 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file hef_store.h
+ * \brief Persistent record store in the High-Endurance Flash.
+ *
+ * The PIC16(L)F170x has no data EEPROM. Instead, the low bytes of the last
+ * 128 program memory words (0x1F80 to 0x1FFF) are High-Endurance Flash
+ * (HEF), organized as 4 rows of 32 bytes. A row can only be erased and
+ * written as a whole, and the CPU stalls for a few ms while it is.
+ *
+ * The hef_store library keeps HEF_STORE_SIZE bytes of application records
+ * in a RAM copy. hef_store_read() and hef_store_write() only access the
+ * copy, so they take constant time and any number of writes can be
+ * collected. hef_store_commit() appends the copy as a new row to a log
+ * that rotates over all 4 rows, so every row is erased only once per 4
+ * commits. Each row carries a sequence number and a checksum:
+ * hef_store_init() loads the newest complete row, so a commit that is
+ * interrupted by a power failure leaves the previous state intact.
+ *
+ * Records are addressed by their offset in a fixed layout, usually a
+ * structure and offsetof(), not by key: a row has no room to spare for
+ * keys and lengths. All persistent data must fit into HEF_STORE_SIZE
+ * (30) bytes.
+ *
+ * The HEF rows must be excluded from the program code, e.g. with the XC8
+ * linker option `--ROM=default,-1f80-1fff`.
+ *
+ * Example:
+ *
+ * \code{.c}
+ *   typedef struct {
+ *     uint16_t boot_count;
+ *     uint8_t brightness;
+ *   } Settings;
+ *
+ *   int main() {
+ *     Settings settings;
+ *
+ *     hef_store_init();
+ *     hef_store_read(0, &settings, sizeof(settings));
+ *     settings.boot_count++;
+ *     hef_store_write(0, &settings, sizeof(settings));
+ *     hef_store_commit();
+ *     // ...
+ *   }
+ * \endcode
+ */
+
+#ifndef HEF_STORE_H
+#define	HEF_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! Program memory address of the first HEF row
+#define HEF_STORE_ADDRESS 0x1F80
+//! Number of HEF rows used by the log
+#define HEF_STORE_ROWS 4
+//! Bytes per HEF row (one per program memory word)
+#define HEF_STORE_ROW_SIZE 32
+//! Record bytes, the remaining bytes of a row hold sequence and checksum
+#define HEF_STORE_SIZE (HEF_STORE_ROW_SIZE - 2)
+
+/**
+ * Loads the newest complete row of the log into the RAM copy. Must be
+ * called before any other hef_store function.
+ *
+ * @return
+ *     False if no complete row was found, e.g. on the first start. All
+ *     record bytes read as 0xFF in this case.
+ */
+bool hef_store_init(void);
+
+/**
+ * Reads record bytes from the RAM copy, including writes that are not
+ * committed yet.
+ *
+ * @param offset
+ *     Offset of the first byte, e.g. `offsetof(Settings, brightness)`.
+ * @param data
+ *     Receives length bytes.
+ * @param length
+ *     Number of bytes to read.
+ * @return
+ *     False if the range exceeds HEF_STORE_SIZE, nothing is read then.
+ */
+bool hef_store_read(uint8_t offset, void* data, uint8_t length);
+
+/**
+ * Writes record bytes to the RAM copy. The flash is not written before
+ * hef_store_commit() is called. Writing the values that are already stored
+ * does not make the store dirty.
+ *
+ * @param offset
+ *     Offset of the first byte.
+ * @param data
+ *     length bytes to write.
+ * @param length
+ *     Number of bytes to write.
+ * @return
+ *     False if the range exceeds HEF_STORE_SIZE, nothing is written then.
+ */
+bool hef_store_write(uint8_t offset, const void* data, uint8_t length);
+
+/**
+ * Checks if the RAM copy contains writes that are not committed.
+ *
+ * @return
+ *     True if hef_store_commit() would write a row.
+ */
+bool hef_store_dirty(void);
+
+/**
+ * Writes the RAM copy to the next HEF row if it is dirty and verifies it.
+ * A row that does not verify is erased again and the next row is tried.
+ *
+ * Interrupts are disabled and the CPU stalls while the row is erased and
+ * written, about 5 ms in total. Peripherals keep running, but timer0
+ * overflows beyond the first one are lost if the timer0 period is shorter.
+ *
+ * @return
+ *     False if no row could be written.
+ */
+bool hef_store_commit(void);
+
+#endif	/* HEF_STORE_H */
@@ -0,0 +1,189 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file i2c.h
+ * \brief Asynchronous I2C master on the MSSP module.
+ * 
+ * The i2c library operates the MSSP module of the PIC as I2C master. Every
+ * step of a transaction (start, address, data, acknowledge, stop) is 
+ * advanced by the MSSP interrupt in i2c_ih(), so the CPU never waits for
+ * the bus. Transactions are described by caller-owned I2cTransaction records
+ * and are processed one after the other from a small queue.
+ * 
+ * A transaction writes write_length bytes, reads read_length bytes, or
+ * writes and then reads with a repeated start in between (e.g. register 
+ * address followed by register data).
+ * 
+ * A stuck slave cannot hang the firmware: i2c_poll() aborts the current
+ * transaction if the bus made no progress for LIBPIC170X_I2C_TIMEOUT_MS 
+ * according to pic170x_timer0. SCL and SDA are routed to any PPS-capable
+ * pin given as `PinDef`.
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   static const uint8_t temp_reg = 0x00;
+ *   static uint8_t temp_data[2];
+ *   static I2cTransaction temp_read = {0x48, &temp_reg, 1, temp_data, 2, NULL};
+ * 
+ *   void interrupt int_handler() {
+ *     timer0_ih(NULL);
+ *     i2c_ih();
+ *   }
+ * 
+ *   int main() {
+ *     // ...
+ *     i2c_init(I2C_CLOCK_CONFIG(100000), PIN_RB6, PIN_RB4);
+ *     GIE = 1;
+ *     i2c_submit(&temp_read);
+ *     while (true) {
+ *       i2c_poll();
+ *       if (temp_read.status == I2C_STATUS_OK) {
+ *         // ...
+ *       }
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef I2C_H
+#define	I2C_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "io_control.h"
+
+#ifndef LIBPIC170X_I2C_QUEUE_SIZE
+  //! Number of transactions that can be queued (power of two, at most 128)
+  #define LIBPIC170X_I2C_QUEUE_SIZE 4
+#endif
+
+#ifndef LIBPIC170X_I2C_TIMEOUT_MS
+  //! Time without bus progress after which a transaction is aborted
+  #define LIBPIC170X_I2C_TIMEOUT_MS 20
+#endif
+
+// The library must be built with the same sizes (see freq.h)
+#define i2c_init __LIBPIC170X_SIZE_TAG2(i2c_init, LIBPIC170X_I2C_QUEUE_SIZE, LIBPIC170X_I2C_TIMEOUT_MS)
+
+//! Transaction completed successfully
+#define I2C_STATUS_OK 0
+//! The slave did not acknowledge its address or a written byte
+#define I2C_STATUS_NACK 1
+//! The bus made no progress for LIBPIC170X_I2C_TIMEOUT_MS
+#define I2C_STATUS_TIMEOUT 2
+//! Another master or a disturbed bus caused a bus collision
+#define I2C_STATUS_COLLISION 3
+//! Transaction is queued or running
+#define I2C_STATUS_PENDING 0xFF
+
+// SSP1ADD value for the given clock, the MSSP does not support values < 3
+#define __LIBPIC170X_I2C_ADD(hz) ((_XTAL_FREQ + 4ul * (hz) - 1) / (4ul * (hz)) - 1)
+
+/**
+ * Clock configuration for i2c_init() that results in the fastest bus clock
+ * that does not exceed hz at _XTAL_FREQ. The low byte holds the SSP1ADD 
+ * value, bit 8 enables slew rate control for clocks above 100 kHz. Intended
+ * for constant arguments.
+ */
+#define I2C_CLOCK_CONFIG(hz) ((uint16_t) ( \
+    ((hz) > 100000ul ? 0x0100 : 0x0000) | \
+    (__LIBPIC170X_I2C_ADD(hz) < 3 ? 3 : \
+     __LIBPIC170X_I2C_ADD(hz) > 255 ? 255 : __LIBPIC170X_I2C_ADD(hz))))
+
+struct I2cTransaction;
+
+/**
+ * Completion callback of a transaction. Runs in the interrupt handler, or
+ * in i2c_poll() for timeouts.
+ */
+typedef void (*I2cCallback)(struct I2cTransaction* transaction);
+
+/**
+ * \brief Description of an I2C transaction.
+ * 
+ * The record and its buffers are owned by the caller and must stay valid
+ * until status is no longer I2C_STATUS_PENDING.
+ */
+typedef struct I2cTransaction {
+    //! 7-bit slave address
+    uint8_t address;
+    //! Bytes to write (can be NULL if write_length is 0)
+    const uint8_t* write_data;
+    //! Number of bytes to write
+    uint8_t write_length;
+    //! Buffer for the bytes to read (can be NULL if read_length is 0)
+    uint8_t* read_data;
+    //! Number of bytes to read after writing, with a repeated start
+    uint8_t read_length;
+    //! Called when the transaction completed or failed (can be NULL)
+    I2cCallback callback;
+    //! One of the I2C_STATUS_ values, set by the library
+    volatile uint8_t status;
+} I2cTransaction;
+
+/**
+ * Configures the MSSP as I2C master and routes SCL and SDA to the given
+ * pins. PEIE is enabled, GIE must be enabled by the caller. The PPS 
+ * registers must not be locked.
+ * 
+ * @param clock_config
+ *     Clock configuration, see I2C_CLOCK_CONFIG().
+ * @param scl
+ *     Clock pin.
+ * @param sda
+ *     Data pin.
+ */
+void i2c_init(uint16_t clock_config, const PinDef* scl, const PinDef* sda);
+
+/**
+ * Queues a transaction. The transaction is started immediately if the bus
+ * is idle.
+ * 
+ * @param transaction
+ *     Transaction to queue. Its status is set to I2C_STATUS_PENDING.
+ * @return
+ *     False if the queue is full.
+ */
+bool i2c_submit(I2cTransaction* transaction);
+
+/**
+ * Checks if a transaction is running or queued.
+ */
+bool i2c_busy(void);
+
+/**
+ * Interrupt handler part. Advances the running transaction and starts the
+ * next queued transaction after a STOP.
+ */
+void i2c_ih(void);
+
+//! Interrupt dispatcher entry (see isr.h)
+#define I2C_ISR_ENTRY ((SSP1IE && SSP1IF) || (BCL1IE && BCL1IF), i2c_ih())
+
+/**
+ * Main loop part. Aborts the running transaction with I2C_STATUS_TIMEOUT if
+ * the bus made no progress for LIBPIC170X_I2C_TIMEOUT_MS, and resets the 
+ * MSSP. The timeout is measured with the timer0 counter, which only
+ * advances in whole timer0 periods: a transaction is aborted after more
+ * than LIBPIC170X_I2C_TIMEOUT_MS and at most the timeout plus two periods.
+ */
+void i2c_poll(void);
+
+#endif	/* I2C_H */
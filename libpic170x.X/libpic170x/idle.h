@@ -0,0 +1,101 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file idle.h
+ * \brief Tickless idle: SLEEP until the next deadline.
+ * 
+ * The idle library puts the PIC into SLEEP instead of letting the main loop
+ * spin between timer0 events. The watchdog timer is used as wake source,
+ * because it is clocked by the LFINTOSC and keeps running while the system
+ * clock (and with it timer0) is halted.
+ * 
+ * The watchdog supports periods of 1.024 ms * 2^n (n = 0 to 18). They are
+ * derived from the LFINTOSC, whose tolerance is large: the datasheet allows
+ * a watchdog period to be more than 1.5 times its nominal value. idle_sleep()
+ * therefore selects one period less than the longest that fits into the
+ * requested time, which keeps the wake-up ahead of the deadline within that
+ * tolerance, but is no hard guarantee. On wake-up the slept time is added to
+ * pic170x_timer0 in whole timer0 periods, the remainder is carried over to
+ * the next sleep, so the counter stays continuous and monotonic.
+ * idle_until_next_timer() additionally advances the soft_timer wheel.
+ * 
+ * The watchdog must be under software control, i.e. the configuration bits
+ * must contain `#pragma config WDTE = SWDTEN`.
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   while (true) {
+ *     soft_timer_run();
+ *     idle_until_next_timer();
+ *   }
+ * \endcode
+ */
+
+#ifndef IDLE_H
+#define	IDLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! Shortest watchdog period in us (1:32 prescaler at the nominal 31.25 kHz)
+#define IDLE_MIN_SLEEP_US 1024ul
+
+//! Largest watchdog prescaler selection (WDTPS = 0b10010, 1:8388608)
+#define IDLE_MAX_SLEEP_SHIFT 18
+
+//! Longest watchdog period in us (~268 s)
+#define IDLE_MAX_SLEEP_US (IDLE_MIN_SLEEP_US << IDLE_MAX_SLEEP_SHIFT)
+
+/**
+ * Sleeps for at most the given time and accounts the slept time to 
+ * pic170x_timer0. 
+ * 
+ * If the PIC is woken up early by an interrupt, the elapsed time cannot be
+ * determined and is not accounted. timer0 then lags behind by at most the
+ * selected watchdog period. Pass shorter times to bound this error if other
+ * interrupt sources are enabled.
+ * 
+ * Do not use this function directly while soft timers are active, use 
+ * idle_until_next_timer() instead, which keeps the timing wheel in sync.
+ * 
+ * @param max_us
+ *     Maximum time to sleep in microseconds. The nominal sleep time is at
+ *     most half of it. If this is shorter than 2 * IDLE_MIN_SLEEP_US the 
+ *     function returns immediately.
+ * @return
+ *     The number of timer0 periods that were added to pic170x_timer0.
+ */
+uint16_t idle_sleep(uint32_t max_us);
+
+/**
+ * Sleeps until the next soft timer expires (see soft_timer.h) or
+ * an interrupt occurs. As the current timer0 period has already partially
+ * elapsed, only the full ticks before the expiry are slept (see 
+ * idle_sleep() for the margin), the remaining time is spent awake. 
+ * Interrupts are disabled from the expiry calculation until the wake-up, so
+ * a timer0 tick in between cancels the sleep instead of delaying the 
+ * expiry. Returns immediately if expired timers are waiting for 
+ * soft_timer_run() or the next expiry is less than 2 * IDLE_MIN_SLEEP_US 
+ * away. If no timer is active, sleeps for IDLE_MAX_SLEEP_US.
+ * 
+ * @return
+ *     True if the PIC slept.
+ */
+bool idle_until_next_timer(void);
+
+#endif	/* IDLE_H */
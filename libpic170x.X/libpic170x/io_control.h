@@ -51,6 +51,43 @@
  * 
  * For a working example on how to use the library, check the "blink" example,
  * in this repository.
+ * 
+ * Compile-time pin access
+ * 
+ * Next to the `pin_` functions, which operate on `PinDef` pointers and can be
+ * used with pins that are only known at runtime, the header defines a set of
+ * `PIN_` macros that take a pin *name* instead (e.g. `RC0`). Register and bit
+ * are resolved by the preprocessor, so with a constant argument the macros
+ * compile to single BSF/BCF/BTFSC instructions. Example:
+ * 
+ * \code{.c}
+ *   PIN_SET_PIN_MODE(RC0, true);
+ *   PIN_SET_OUTPUT(RC0, true);
+ *   if (PIN_GET_INPUT(RA2)) {
+ *     PIN_TOGGLE_OUTPUT(RC0);
+ *   }
+ * \endcode
+ * 
+ * Using a pin name that does not exist on the compiled chip (e.g. `RB4` on a
+ * PIC16(L)F1705) results in a compile-time error. The macros expand to direct
+ * SFR accesses, so `xc.h` must be included where they are used.
+ * 
+ * Compact pin handles
+ * 
+ * A `PinId` identifies a pin in a single byte, `PIN_ID(RC0)` or pin_id(). 
+ * The `pin_id_` functions compute the TRISx, LATx, PORTx and ANSELx 
+ * registers from it by indexed addressing, which makes tables of pins 
+ * (keypad rows, LED matrix columns, ...) smaller than tables of `PinDef` 
+ * pointers and faster to iterate:
+ * 
+ * \code{.c}
+ *   static const PinId rows[] = {PIN_ID(RC0), PIN_ID(RC1), PIN_ID(RC2)};
+ *   uint8_t i;
+ * 
+ *   for (i = 0; i < sizeof(rows); i++) {
+ *     pin_id_set_pin_mode(rows[i], true);
+ *   }
+ * \endcode
  */
 
 #ifndef IO_CONTROL_H
@@ -140,6 +177,374 @@ void pin_set_output(const PinDef* def, bool on);
  */
 void pin_set_input_mode(const PinDef* def, uint8_t input_mode);
 
+/**
+ * Selects the peripheral output that drives a pin through its RxyPPS
+ * register. Use one of the PIN_OUTPUT_SOURCE_ values. Only has an effect if
+ * the pin supports outputs and the PPS registers are not locked (PPSLOCKED).
+ * 
+ * @param def
+ *     The pin to route the output to.
+ * @param source
+ *     Output source, PIN_OUTPUT_SOURCE_LATCH restores the normal LATx output.
+ */
+void pin_set_output_source(const PinDef* def, uint8_t source);
+
+//! Output source (see pin_set_output_source()): LATx register
+#define PIN_OUTPUT_SOURCE_LATCH 0x00
+//! Output source (see pin_set_output_source()): CCP1 output
+#define PIN_OUTPUT_SOURCE_CCP1 0x0C
+//! Output source (see pin_set_output_source()): CCP2 output
+#define PIN_OUTPUT_SOURCE_CCP2 0x0D
+//! Output source (see pin_set_output_source()): PWM3 output
+#define PIN_OUTPUT_SOURCE_PWM3 0x0E
+//! Output source (see pin_set_output_source()): PWM4 output
+#define PIN_OUTPUT_SOURCE_PWM4 0x0F
+//! Output source (see pin_set_output_source()): MSSP SCK (SPI) or SCL (I2C)
+#define PIN_OUTPUT_SOURCE_SCK_SCL 0x10
+//! Output source (see pin_set_output_source()): MSSP SDA (I2C)
+#define PIN_OUTPUT_SOURCE_SDA 0x11
+//! Output source (see pin_set_output_source()): MSSP SDO (SPI)
+#define PIN_OUTPUT_SOURCE_SDO 0x12
+//! Output source (see pin_set_output_source()): EUSART TX (async) or CK (sync)
+#define PIN_OUTPUT_SOURCE_TX_CK 0x14
+//! Output source (see pin_set_output_source()): EUSART DT (sync)
+#define PIN_OUTPUT_SOURCE_DT 0x15
+
+
+/**
+ * \brief One-byte pin handle.
+ * 
+ * Encodes the port index (A = 0, B = 1, C = 2) in bits 3-4 and the bit
+ * number in bits 0-2, which is the same value as PinDef.pin_pps.
+ */
+typedef uint8_t PinId;
+
+/**
+ * Invalid PinId, e.g. for pins that do not exist on the compiled chip. The
+ * pin_id_ functions ignore it like all other ids of missing pins.
+ */
+#define PIN_ID_NONE 0xFF
+
+//! Single-bit masks of the bit numbers 0 to 7, see PIN_ID_MASK()
+extern const uint8_t pic170x_pin_id_masks[8];
+
+/**
+ * Bit mask of a PinId within its port registers. Uses a table lookup
+ * instead of a variable shift, which the core can only do in a loop.
+ */
+#define PIN_ID_MASK(id) (pic170x_pin_id_masks[(id) & 0x07])
+
+/**
+ * Returns the PinId of a pin.
+ * 
+ * @param def
+ *     The pin, can be NULL.
+ * @return
+ *     The PinId or PIN_ID_NONE if def is NULL.
+ */
+PinId pin_id(const PinDef* def);
+
+/**
+ * Like pin_set_pin_mode(), for a PinId. Ids of pins that the compiled chip
+ * does not have, like PIN_ID_NONE, are ignored.
+ * 
+ * @param id
+ *     Pin to configure.
+ * @param output
+ *     Set to true to make it an output, false to make it a digital input.
+ */
+void pin_id_set_pin_mode(PinId id, bool output);
+
+/**
+ * Like pin_get_input(), for a PinId.
+ * 
+ * @param id
+ *     The pin to read the input state from.
+ * @return 
+ *     True if the input is high, false for ids of missing pins.
+ */
+bool pin_id_get_input(PinId id);
+
+/**
+ * Like pin_set_output(), for a PinId. Ids of missing pins are ignored.
+ * 
+ * @param id
+ *     The pin to write.
+ * @param on
+ *     True to set output high, false to set the output to low.
+ */
+void pin_id_set_output(PinId id, bool on);
+
+/**
+ * Inverts the output latch of a pin. Ids of missing pins are ignored.
+ * 
+ * @param id
+ *     The pin to toggle.
+ */
+void pin_id_toggle_output(PinId id);
+
+/**
+ * Like pin_set_input_mode(), for a PinId. Ids of missing pins are ignored.
+ * 
+ * @param id
+ *     The pin to set the input mode for.
+ * @param input_mode
+ *     Set to PIN_INPUT_MODE_ANALOG or PIN_INPUT_MODE_DIGITAL.
+ */
+void pin_id_set_input_mode(PinId id, uint8_t input_mode);
+
+
+//! Maximum number of ports a PinGroup can span (PORTA, PORTB and PORTC)
+#define PIN_GROUP_MAX_PORTS 3
+
+/**
+ * \brief Registers and combined pin mask of a single port within a PinGroup.
+ */
+typedef struct {
+    //! Combined bitmask of all group members on this port
+    uint8_t mask;
+    
+    //! Pointer to the port's tris register (can be NULL)
+    volatile unsigned char *tris_reg;
+    //! Pointer to the port's port register (never NULL)
+    volatile unsigned char *port_reg;
+    //! Pointer to the port's output register (can be NULL)
+    volatile unsigned char *latch_reg;
+} PinGroupPort;
+
+/**
+ * \brief Collection of pins that are accessed together.
+ * 
+ * A pin group combines the `pin_tris_bitmask` values of its members into one
+ * mask per port, so that all members on the same port are written or sampled
+ * with a single register access. Pin groups are initialized with
+ * pin_group_init(). Ports are stored in the order in which they first appear
+ * in the pin list used for initialization.
+ */
+typedef struct {
+    //! Number of used entries in ports
+    uint8_t port_count;
+    //! Per-port masks and registers
+    PinGroupPort ports[PIN_GROUP_MAX_PORTS];
+} PinGroup;
+
+/**
+ * Initializes a pin group from a list of pins. NULL pins (e.g. `PIN_RB4` on a
+ * PIC16(L)F1705) are skipped.
+ * 
+ * @param group
+ *     The group to initialize.
+ * @param pins
+ *     Array of pins that should become members of the group.
+ * @param count
+ *     Number of entries in pins.
+ */
+void pin_group_init(PinGroup* group, const PinDef* const* pins, uint8_t count);
+
+/**
+ * Initializes a pin group from a list of PinIds, see pin_group_init(). 
+ * PIN_ID_NONE and ids of missing pins are skipped.
+ * 
+ * @param group
+ *     The group to initialize.
+ * @param ids
+ *     Array of pins that should become members of the group.
+ * @param count
+ *     Number of entries in ids.
+ */
+void pin_group_init_ids(PinGroup* group, const PinId* ids, uint8_t count);
+
+/**
+ * Configures all pins of a group as input or output. Writes each involved
+ * TRISx register once.
+ * 
+ * @param group
+ *     Pins to configure.
+ * @param output
+ *     Set to true to make them outputs, false to make them digital inputs.
+ */
+void pin_group_set_pin_mode(const PinGroup* group, bool output);
+
+/**
+ * Sets all outputs of a group high or low. All members on the same port
+ * change state with the same instruction.
+ * 
+ * @param group
+ *     Pins to write.
+ * @param on
+ *     True to set all outputs high, false to set all outputs low.
+ */
+void pin_group_set_outputs(const PinGroup* group, bool on);
+
+/**
+ * Inverts all outputs of a group.
+ * 
+ * @param group
+ *     Pins to toggle.
+ */
+void pin_group_toggle_outputs(const PinGroup* group);
+
+/**
+ * Writes individual output values for all pins of a group. values holds one
+ * byte per group port (see PinGroup.ports) in the layout of the LATx
+ * register. Bits that do not belong to the group are ignored.
+ * 
+ * @param group
+ *     Pins to write.
+ * @param values
+ *     Array of PinGroup.port_count LATx values.
+ */
+void pin_group_write(const PinGroup* group, const uint8_t* values);
+
+/**
+ * Samples the PORTx registers of all pins of a group. Writes one byte per
+ * group port into values, with all bits that do not belong to the group
+ * cleared. Use pin_group_get_value() to extract the state of single pins.
+ * 
+ * @param group
+ *     Pins to sample.
+ * @param values
+ *     Array receiving PinGroup.port_count values.
+ */
+void pin_group_read(const PinGroup* group, uint8_t* values);
+
+/**
+ * Extracts the state of a single pin from values that were sampled with
+ * pin_group_read().
+ * 
+ * @param group
+ *     Group that was used to sample the values.
+ * @param values
+ *     Values returned by pin_group_read().
+ * @param def
+ *     The pin to extract the state for.
+ * @return
+ *     True if the pin was high. False if the pin was low or is not a member
+ *     of the group.
+ */
+bool pin_group_get_value(const PinGroup* group, const uint8_t* values, const PinDef* def);
+
+/*
+ * Compile-time pin descriptors. Each descriptor expands to the port letter,
+ * the port index (A = 0, B = 1, C = 2) and the bit number of the pin. The
+ * pin tables in io_control.c are derived from the same descriptors.
+ */
+#if defined(_16F1705) || defined(_16LF1705) || defined(__LIBPIC170X_DOXYGEN)
+  #define __LIBPIC170X_PIN_RA0 A, 0, 0
+  #define __LIBPIC170X_PIN_RA1 A, 0, 1
+  #define __LIBPIC170X_PIN_RA2 A, 0, 2
+  #define __LIBPIC170X_PIN_RA3 A, 0, 3
+  #define __LIBPIC170X_PIN_RA4 A, 0, 4
+  #define __LIBPIC170X_PIN_RA5 A, 0, 5
+
+  #define __LIBPIC170X_PIN_RC0 C, 2, 0
+  #define __LIBPIC170X_PIN_RC1 C, 2, 1
+  #define __LIBPIC170X_PIN_RC2 C, 2, 2
+  #define __LIBPIC170X_PIN_RC3 C, 2, 3
+  #define __LIBPIC170X_PIN_RC4 C, 2, 4
+  #define __LIBPIC170X_PIN_RC5 C, 2, 5
+#elif defined(_16F1709) || defined(_16LF1709)
+  #define __LIBPIC170X_PIN_RA0 A, 0, 0
+  #define __LIBPIC170X_PIN_RA1 A, 0, 1
+  #define __LIBPIC170X_PIN_RA2 A, 0, 2
+  #define __LIBPIC170X_PIN_RA3 A, 0, 3
+  #define __LIBPIC170X_PIN_RA4 A, 0, 4
+  #define __LIBPIC170X_PIN_RA5 A, 0, 5
+
+  #define __LIBPIC170X_PIN_RB4 B, 1, 4
+  #define __LIBPIC170X_PIN_RB5 B, 1, 5
+  #define __LIBPIC170X_PIN_RB6 B, 1, 6
+  #define __LIBPIC170X_PIN_RB7 B, 1, 7
+
+  #define __LIBPIC170X_PIN_RC0 C, 2, 0
+  #define __LIBPIC170X_PIN_RC1 C, 2, 1
+  #define __LIBPIC170X_PIN_RC2 C, 2, 2
+  #define __LIBPIC170X_PIN_RC3 C, 2, 3
+  #define __LIBPIC170X_PIN_RC4 C, 2, 4
+  #define __LIBPIC170X_PIN_RC5 C, 2, 5
+  #define __LIBPIC170X_PIN_RC6 C, 2, 6
+  #define __LIBPIC170X_PIN_RC7 C, 2, 7
+#endif
+
+// Expands the descriptor in args before invoking macro with it
+#define __LIBPIC170X_PIN_APPLY(macro, args) macro args
+
+#define __LIBPIC170X_PIN_MASK(port, index, bit) ((uint8_t) (1u << (bit)))
+#define __LIBPIC170X_PIN_PPS(port, index, bit) ((uint8_t) (((index) << 3) | (bit)))
+
+#define __LIBPIC170X_PIN_SET_PIN_MODE(port, index, bit, output) \
+    do { \
+        if (output) { TRIS##port &= (uint8_t) ~(1u << (bit)); } \
+        else { TRIS##port |= (uint8_t) (1u << (bit)); } \
+    } while (0)
+#define __LIBPIC170X_PIN_SET_OUTPUT(port, index, bit, on) \
+    do { \
+        if (on) { LAT##port |= (uint8_t) (1u << (bit)); } \
+        else { LAT##port &= (uint8_t) ~(1u << (bit)); } \
+    } while (0)
+#define __LIBPIC170X_PIN_TOGGLE_OUTPUT(port, index, bit) \
+    do { LAT##port ^= (uint8_t) (1u << (bit)); } while (0)
+#define __LIBPIC170X_PIN_GET_INPUT(port, index, bit) \
+    ((TRIS##port & (1u << (bit))) \
+        ? ((PORT##port & (1u << (bit))) != 0) \
+        : ((LAT##port & (1u << (bit))) != 0))
+#define __LIBPIC170X_PIN_GET_PORT(port, index, bit) \
+    ((PORT##port & (1u << (bit))) != 0)
+#define __LIBPIC170X_PIN_SET_INPUT_MODE(port, index, bit, input_mode) \
+    do { \
+        if ((input_mode) == PIN_INPUT_MODE_DIGITAL) { ANSEL##port &= (uint8_t) ~(1u << (bit)); } \
+        else { ANSEL##port |= (uint8_t) (1u << (bit)); } \
+    } while (0)
+
+//! Bitmask of the named pin within its port registers (same as PinDef.pin_tris_bitmask)
+#define PIN_MASK(pin) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_MASK, (__LIBPIC170X_PIN_##pin))
+//! Input PPS value of the named pin (same as PinDef.pin_pps)
+#define PIN_PPS(pin) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_PPS, (__LIBPIC170X_PIN_##pin))
+//! PinId of the named pin
+#define PIN_ID(pin) ((PinId) PIN_PPS(pin))
+
+/**
+ * Compile-time variant of pin_set_pin_mode(). Takes a pin name like `RC0`
+ * instead of a `PinDef`.
+ */
+#define PIN_SET_PIN_MODE(pin, output) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_SET_PIN_MODE, (__LIBPIC170X_PIN_##pin, output))
+
+/**
+ * Compile-time variant of pin_set_output(). Compiles to a single BSF or BCF
+ * instruction if `on` is a constant.
+ */
+#define PIN_SET_OUTPUT(pin, on) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_SET_OUTPUT, (__LIBPIC170X_PIN_##pin, on))
+
+/**
+ * Inverts the output latch of the named pin.
+ */
+#define PIN_TOGGLE_OUTPUT(pin) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_TOGGLE_OUTPUT, (__LIBPIC170X_PIN_##pin))
+
+/**
+ * Compile-time variant of pin_get_input(). Like the function, it returns the
+ * latched output value if the pin is configured as output.
+ */
+#define PIN_GET_INPUT(pin) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_GET_INPUT, (__LIBPIC170X_PIN_##pin))
+
+/**
+ * Reads the PORTx bit of the named pin regardless of the pin mode. Compiles
+ * to a single BTFSC/BTFSS when used as a condition.
+ */
+#define PIN_GET_PORT(pin) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_GET_PORT, (__LIBPIC170X_PIN_##pin))
+
+/**
+ * Compile-time variant of pin_set_input_mode().
+ */
+#define PIN_SET_INPUT_MODE(pin, input_mode) \
+    __LIBPIC170X_PIN_APPLY(__LIBPIC170X_PIN_SET_INPUT_MODE, (__LIBPIC170X_PIN_##pin, input_mode))
+
 
 //! PIN_RA0 defintion
 extern const PinDef* PIN_RA0;
@@ -0,0 +1,146 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file ioc.h
+ * \brief Interrupt-on-change pin events.
+ * 
+ * Extends the Pin IO library (io_control.h) with edge detection through the
+ * interrupt-on-change (IOC) module of the PIC. Rising and/or falling edges
+ * can be enabled per pin. The interrupt handler part ioc_ih() records every
+ * detected edge together with a timer0 timestamp in a fixed-size queue (a
+ * RingBuffer, see ring_buffer.h), the main loop drains the queue in batches
+ * with ioc_read_events().
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     timer0_ih(NULL);
+ *     ioc_ih();
+ *   }
+ * 
+ *   int main() {
+ *     IocEvent events[4];
+ *     uint8_t i, n;
+ *     // ...
+ *     ioc_init();
+ *     ioc_enable(PIN_RA2, IOC_EDGE_FALLING);
+ *     GIE = 1;
+ *     while (true) {
+ *       n = ioc_read_events(events, 4);
+ *       for (i = 0; i < n; i++) {
+ *         // handle events[i]
+ *       }
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef IOC_H
+#define	IOC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "io_control.h"
+
+#ifndef LIBPIC170X_IOC_QUEUE_SIZE
+  //! Number of events the queue can hold (must be a power of two, at most 128)
+  #define LIBPIC170X_IOC_QUEUE_SIZE 8
+#endif
+
+#if (LIBPIC170X_IOC_QUEUE_SIZE & (LIBPIC170X_IOC_QUEUE_SIZE - 1)) != 0 || LIBPIC170X_IOC_QUEUE_SIZE > 128
+  #error "LIBPIC170X_IOC_QUEUE_SIZE must be a power of two and at most 128"
+#endif
+
+// The library must be built with the same sizes (see freq.h)
+#define ioc_init __LIBPIC170X_SIZE_TAG(ioc_init, LIBPIC170X_IOC_QUEUE_SIZE)
+
+//! Edge selection and event type: low-to-high transition
+#define IOC_EDGE_RISING 0x01
+//! Edge selection and event type: high-to-low transition
+#define IOC_EDGE_FALLING 0x02
+//! Edge selection: both transitions
+#define IOC_EDGE_BOTH (IOC_EDGE_RISING | IOC_EDGE_FALLING)
+
+/**
+ * \brief A recorded pin edge.
+ */
+typedef struct {
+    //! Input PPS value of the pin (see PinDef.pin_pps)
+    uint8_t pin_pps;
+    //! IOC_EDGE_RISING or IOC_EDGE_FALLING
+    uint8_t edge;
+    //! Value of pic170x_timer0.ms when the edge was processed
+    uint32_t ms;
+} IocEvent;
+
+/**
+ * Disables edge detection on all pins, clears the event queue and enables
+ * the IOC interrupt. GIE must be enabled by the caller.
+ */
+void ioc_init(void);
+
+/**
+ * Selects the edges that are detected for a pin. 
+ * 
+ * @param def
+ *     Pin to configure. The pin should be configured as digital input.
+ * @param edges
+ *     Combination of IOC_EDGE_RISING and IOC_EDGE_FALLING, or 0 to disable
+ *     edge detection for the pin.
+ */
+void ioc_enable(const PinDef* def, uint8_t edges);
+
+/**
+ * Interrupt handler part. Records all pending edges in the event queue and
+ * clears the corresponding flags. Edges are dropped if the queue is full 
+ * (see ioc_dropped_events()).
+ * 
+ * If both edges are enabled for a pin, the edge type is determined from the
+ * pin level at the time the interrupt is processed. Pulses shorter than the
+ * interrupt latency can therefore be recorded with the wrong edge type.
+ * 
+ * @return
+ *     True if an IOC interrupt was processed.
+ */
+bool ioc_ih(void);
+
+//! Interrupt dispatcher entry (see isr.h)
+#define IOC_ISR_ENTRY (IOCIF, ioc_ih())
+
+/**
+ * Main loop part. Moves up to max events from the queue into events, oldest
+ * first.
+ * 
+ * @param events
+ *     Buffer for at least max events.
+ * @param max
+ *     Maximum number of events to read.
+ * @return
+ *     Number of events that were read.
+ */
+uint8_t ioc_read_events(IocEvent* events, uint8_t max);
+
+/**
+ * Returns the number of edges that were dropped since ioc_init() because 
+ * the queue was full. The counter saturates at 255.
+ */
+uint8_t ioc_dropped_events(void);
+
+#endif	/* IOC_H */
@@ -0,0 +1,106 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file isr.h
+ * \brief Interrupt dispatcher assembled at compile time.
+ *
+ * Including this header defines the interrupt function of the application,
+ * `libpic170x_isr()`. It checks the interrupt sources that are listed in
+ * the slots `LIBPIC170X_ISR_1` to `LIBPIC170X_ISR_8`, in this order, and
+ * runs the handler of every pending source. Sources that are not listed
+ * are not checked at all.
+ *
+ * Every slot is set to a dispatcher entry, a pair of `(condition,
+ * statements)`. The library headers define entries for their interrupt
+ * handlers, e.g. TIMER0_ISR_ENTRY, EUSART_ISR_ENTRY or ADC_ISR_ENTRY.
+ * Entries are expanded into a plain if-chain, so no function pointers are
+ * involved. TIMER0_ISR_ENTRY updates pic170x_timer0 inline, without the
+ * call and NULL check of timer0_ih(). Statements that should run on every
+ * timer0 tick (e.g. soft_timer_tick()) are given by
+ * LIBPIC170X_ISR_TIMER0_TICK().
+ *
+ * The slots must be defined before this header is included, in exactly one
+ * source file of the application. The application must not define another
+ * interrupt function.
+ *
+ * Example:
+ *
+ * \code{.c}
+ *   #include <xc.h>
+ *   #include <libpic170x/timer0.h>
+ *   #include <libpic170x/soft_timer.h>
+ *   #include <libpic170x/eusart.h>
+ *
+ *   #define LIBPIC170X_ISR_1 EUSART_ISR_ENTRY
+ *   #define LIBPIC170X_ISR_2 TIMER0_ISR_ENTRY
+ *   #define LIBPIC170X_ISR_3 (INTF, INTF = 0; button_pressed = true)
+ *   #define LIBPIC170X_ISR_TIMER0_TICK() soft_timer_tick()
+ *   #include <libpic170x/isr.h>
+ * \endcode
+ */
+
+#ifndef ISR_H
+#define	ISR_H
+
+#include <xc.h>
+
+#include "timer0.h"
+
+#ifndef LIBPIC170X_ISR_1
+  #error "Define at least LIBPIC170X_ISR_1 before including isr.h"
+#endif
+
+#ifndef LIBPIC170X_ISR_TIMER0_TICK
+  //! Statements run by TIMER0_ISR_ENTRY after each counter update (default: none)
+  #define LIBPIC170X_ISR_TIMER0_TICK()
+#endif
+
+// Expands the entry in args before invoking macro with it
+#define __LIBPIC170X_ISR_APPLY(macro, args) macro args
+#define __LIBPIC170X_ISR_IF(condition, statements) if (condition) { statements; }
+#define __LIBPIC170X_ISR_DISPATCH(entry) __LIBPIC170X_ISR_APPLY(__LIBPIC170X_ISR_IF, entry)
+
+/**
+ * Interrupt function of the application. Checks the configured slots in
+ * order.
+ */
+void interrupt libpic170x_isr(void) {
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_1)
+#ifdef LIBPIC170X_ISR_2
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_2)
+#endif
+#ifdef LIBPIC170X_ISR_3
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_3)
+#endif
+#ifdef LIBPIC170X_ISR_4
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_4)
+#endif
+#ifdef LIBPIC170X_ISR_5
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_5)
+#endif
+#ifdef LIBPIC170X_ISR_6
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_6)
+#endif
+#ifdef LIBPIC170X_ISR_7
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_7)
+#endif
+#ifdef LIBPIC170X_ISR_8
+    __LIBPIC170X_ISR_DISPATCH(LIBPIC170X_ISR_8)
+#endif
+}
+
+#endif	/* ISR_H */
@@ -0,0 +1,155 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file pwm.h
+ * \brief Hardware PWM outputs on timer2.
+ * 
+ * The pwm library generates PWM signals with the CCP1, CCP2, PWM3 and PWM4
+ * modules of the PIC. All four channels share the period of timer2 and are
+ * routed to any PPS-capable pin given as `PinDef`. Once configured, the 
+ * waveforms are generated by hardware without any CPU involvement.
+ * 
+ * The timer2 prescaler and period register are computed at compile time
+ * from _XTAL_FREQ with PWM_CONFIG(). Duty cycles are given in steps of
+ * 1 / PWM_DUTY_MAX() of the period, PWM_DUTY_MAX() is the value for 100 %.
+ * 
+ * A 10-bit duty cycle is split over two registers, so a period that starts
+ * between the two writes would use a mix of old and new value. 
+ * pwm_set_duty() therefore hands new duty cycles to the interrupt handler
+ * pwm_ih(), which writes them right after a period started.
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     pwm_ih();
+ *   }
+ * 
+ *   int main() {
+ *     // ...
+ *     pwm_init(PWM_CONFIG(20000));
+ *     pwm_enable(PWM_CHANNEL_PWM3, PIN_RC5, PWM_DUTY_MAX(20000) / 2);
+ *     GIE = 1;
+ *   }
+ * \endcode
+ */
+
+#ifndef PWM_H
+#define	PWM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "io_control.h"
+
+//! PWM channel of the CCP1 module
+#define PWM_CHANNEL_CCP1 0
+//! PWM channel of the CCP2 module
+#define PWM_CHANNEL_CCP2 1
+//! PWM channel of the PWM3 module
+#define PWM_CHANNEL_PWM3 2
+//! PWM channel of the PWM4 module
+#define PWM_CHANNEL_PWM4 3
+//! Number of PWM channels
+#define PWM_CHANNEL_COUNT 4
+
+// Timer2 period register value for the given frequency and prescaler
+#define __LIBPIC170X_PWM_PR2(hz, prescale) \
+    ((_XTAL_FREQ + 2ul * (prescale) * (hz)) / (4ul * (prescale) * (hz)) - 1)
+
+// Smallest timer2 prescaler (as T2CKPS value) that reaches the frequency
+#define __LIBPIC170X_PWM_CKPS(hz) ( \
+    (__LIBPIC170X_PWM_PR2(hz, 1) <= 255) ? 0 : \
+    (__LIBPIC170X_PWM_PR2(hz, 4) <= 255) ? 1 : \
+    (__LIBPIC170X_PWM_PR2(hz, 16) <= 255) ? 2 : 3)
+
+#define __LIBPIC170X_PWM_PR2_SEL(hz) \
+    __LIBPIC170X_PWM_PR2(hz, 1ul << (2 * __LIBPIC170X_PWM_CKPS(hz)))
+
+/**
+ * Timer2 configuration for pwm_init() with the PWM frequency closest to hz
+ * at _XTAL_FREQ, using the smallest prescaler for the highest duty cycle 
+ * resolution. The high byte holds the T2CKPS bits, the low byte PR2. 
+ * Intended for constant arguments.
+ * 
+ * Frequencies range from _XTAL_FREQ / 65536 to _XTAL_FREQ / 4 (with a duty
+ * cycle resolution of 2 bits at the top end).
+ */
+#define PWM_CONFIG(hz) ((uint16_t) ((__LIBPIC170X_PWM_CKPS(hz) << 8) | \
+    (__LIBPIC170X_PWM_PR2_SEL(hz) > 255 ? 255 : __LIBPIC170X_PWM_PR2_SEL(hz))))
+
+/**
+ * Duty cycle value for a constant 100 % output at the frequency selected by
+ * PWM_CONFIG(hz). This is 4 * (PR2 + 1), at most 1024 (10-bit resolution).
+ */
+#define PWM_DUTY_MAX(hz) ((uint16_t) (4u * ((PWM_CONFIG(hz) & 0xFF) + 1u)))
+
+/**
+ * Configures and starts timer2 as the PWM time base of all channels.
+ * Enables PEIE, GIE must be enabled by the caller for pwm_set_duty().
+ * 
+ * @param config
+ *     Timer2 configuration, see PWM_CONFIG().
+ */
+void pwm_init(uint16_t config);
+
+/**
+ * Enables a PWM channel and routes its output to the given pin.
+ * The PPS registers must not be locked.
+ * 
+ * @param channel
+ *     One of the PWM_CHANNEL_ values.
+ * @param pin
+ *     Output pin.
+ * @param duty
+ *     Initial duty cycle between 0 and PWM_DUTY_MAX().
+ */
+void pwm_enable(uint8_t channel, const PinDef* pin, uint16_t duty);
+
+/**
+ * Disables a PWM channel and returns the pin to its LATx output.
+ * 
+ * @param channel
+ *     One of the PWM_CHANNEL_ values.
+ * @param pin
+ *     The pin passed to pwm_enable().
+ */
+void pwm_disable(uint8_t channel, const PinDef* pin);
+
+/**
+ * Changes the duty cycle of a channel without glitches. The new value is
+ * applied by pwm_ih() at the start of the next period and becomes visible
+ * on the output one period later.
+ * 
+ * @param channel
+ *     One of the PWM_CHANNEL_ values.
+ * @param duty
+ *     Duty cycle between 0 and PWM_DUTY_MAX().
+ */
+void pwm_set_duty(uint8_t channel, uint16_t duty);
+
+/**
+ * Interrupt handler part. Writes pending duty cycles when a timer2 period
+ * started.
+ */
+void pwm_ih(void);
+
+//! Interrupt dispatcher entry (see isr.h)
+#define PWM_ISR_ENTRY (TMR2IE && TMR2IF, pwm_ih())
+
+#endif	/* PWM_H */
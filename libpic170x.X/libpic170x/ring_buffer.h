@@ -0,0 +1,184 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file ring_buffer.h
+ * \brief Lock-free single-producer/single-consumer ring buffer.
+ * 
+ * A RingBuffer passes fixed-size records from exactly one producer to 
+ * exactly one consumer, typically from an interrupt handler to the main loop
+ * or vice versa. No interrupts are masked on either side.
+ * 
+ * The capacity must be a power of two of at most 128 records. head and tail
+ * are free-running 8-bit indices, so every index update is a single, atomic
+ * write on the 8-bit core. The producer only writes head, the consumer only
+ * writes tail. Storage is provided by the caller, so RAM usage stays static
+ * and explicit:
+ * 
+ * \code{.c}
+ *   static uint8_t rx_storage[16];
+ *   static RingBuffer rx;
+ * 
+ *   void interrupt int_handler() {
+ *     if (RCIF) {
+ *       ring_buffer_push_byte(&rx, RC1REG);
+ *     }
+ *   }
+ * 
+ *   int main() {
+ *     uint8_t c;
+ *     ring_buffer_init(&rx, rx_storage, 16, 1);
+ *     // ...
+ *     while (true) {
+ *       while (ring_buffer_pop_byte(&rx, &c)) {
+ *         // process c
+ *       }
+ *     }
+ *   }
+ * \endcode
+ * 
+ * Functions named push are producer functions, functions named pop are
+ * consumer functions. ring_buffer_count() and ring_buffer_space() can be 
+ * used from both sides; the result is exact for the caller's own side and
+ * conservative for the other side.
+ */
+
+#ifndef RING_BUFFER_H
+#define	RING_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief State of a ring buffer. 
+ * 
+ * All fields are managed by the ring_buffer functions.
+ */
+typedef struct {
+    //! Storage for capacity * record_size bytes
+    uint8_t* data;
+    //! capacity - 1
+    uint8_t mask;
+    //! Size of a single record in bytes
+    uint8_t record_size;
+    //! Free-running write index, only written by the producer
+    volatile uint8_t head;
+    //! Free-running read index, only written by the consumer
+    volatile uint8_t tail;
+} RingBuffer;
+
+/**
+ * Initializes an empty ring buffer. Must not be called while the producer
+ * or consumer might access the buffer.
+ * 
+ * @param rb
+ *     Ring buffer to initialize.
+ * @param storage
+ *     Memory for at least capacity * record_size bytes.
+ * @param capacity
+ *     Number of records, must be a power of two between 1 and 128.
+ * @param record_size
+ *     Size of each record in bytes (at least 1).
+ * @return
+ *     False if capacity or record_size are invalid.
+ */
+bool ring_buffer_init(RingBuffer* rb, void* storage, uint8_t capacity, uint8_t record_size);
+
+/**
+ * Returns the number of records that are stored in the buffer.
+ */
+uint8_t ring_buffer_count(const RingBuffer* rb);
+
+/**
+ * Returns the number of records that can be pushed into the buffer.
+ */
+uint8_t ring_buffer_space(const RingBuffer* rb);
+
+/**
+ * Producer: appends a single record.
+ * 
+ * @param rb
+ *     Ring buffer to write to.
+ * @param record
+ *     Record of record_size bytes.
+ * @return
+ *     False if the buffer is full.
+ */
+bool ring_buffer_push(RingBuffer* rb, const void* record);
+
+/**
+ * Producer: appends as many of the given records as fit into the buffer.
+ * 
+ * @param rb
+ *     Ring buffer to write to.
+ * @param records
+ *     Array of count records.
+ * @param count
+ *     Number of records to append.
+ * @return
+ *     The number of records that were appended.
+ */
+uint8_t ring_buffer_push_bulk(RingBuffer* rb, const void* records, uint8_t count);
+
+/**
+ * Producer: appends a single byte to a buffer with a record size of 1.
+ * Avoids the record size computations of ring_buffer_push().
+ * 
+ * @return
+ *     False if the buffer is full.
+ */
+bool ring_buffer_push_byte(RingBuffer* rb, uint8_t value);
+
+/**
+ * Consumer: removes the oldest record.
+ * 
+ * @param rb
+ *     Ring buffer to read from.
+ * @param record
+ *     Buffer for record_size bytes.
+ * @return
+ *     False if the buffer is empty.
+ */
+bool ring_buffer_pop(RingBuffer* rb, void* record);
+
+/**
+ * Consumer: removes up to count of the oldest records.
+ * 
+ * @param rb
+ *     Ring buffer to read from.
+ * @param records
+ *     Buffer for count records.
+ * @param count
+ *     Maximum number of records to remove.
+ * @return
+ *     The number of records that were removed.
+ */
+uint8_t ring_buffer_pop_bulk(RingBuffer* rb, void* records, uint8_t count);
+
+/**
+ * Consumer: removes the oldest byte from a buffer with a record size of 1.
+ * 
+ * @return
+ *     False if the buffer is empty.
+ */
+bool ring_buffer_pop_byte(RingBuffer* rb, uint8_t* value);
+
+/**
+ * Consumer: discards all stored records.
+ */
+void ring_buffer_clear(RingBuffer* rb);
+
+#endif	/* RING_BUFFER_H */
@@ -0,0 +1,186 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file soft_timer.h
+ * \brief Software timers driven by the timer0 interrupt.
+ *
+ * The soft_timer library multiplexes a fixed number of one-shot and periodic
+ * software timers onto the timer0 interrupt. Timers are identified by their
+ * slot number (0 to LIBPIC170X_SOFT_TIMER_COUNT - 1) and are statically
+ * allocated, no heap is used.
+ *
+ * Active timers are kept in a hashed timing wheel with
+ * LIBPIC170X_SOFT_TIMER_WHEEL_SIZE buckets. Starting and stopping a timer is
+ * O(1). On every timer0 interrupt, soft_timer_tick() only visits the timers
+ * in a single bucket, so each active timer costs a few instructions once per
+ * wheel revolution. Expired timers are only flagged by the interrupt handler,
+ * their callbacks are run from the main loop by soft_timer_run().
+ *
+ * Delays and periods are given in ticks, where one tick is one timer0
+ * interrupt period (TIMER0_PERIOD_US, see freq.h). SOFT_TIMER_MS_TO_TICKS()
+ * converts milliseconds at compile time.
+ *
+ * Example:
+ *
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     if (timer0_ih(NULL)) {
+ *       soft_timer_tick();
+ *     }
+ *   }
+ *
+ *   void blink(uint8_t timer) {
+ *     pin_set_output(PIN_RC0, !pin_get_input(PIN_RC0));
+ *   }
+ *
+ *   int main() {
+ *     // ...
+ *     soft_timer_init();
+ *     soft_timer_start(0, SOFT_TIMER_MS_TO_TICKS(500), SOFT_TIMER_MS_TO_TICKS(500), blink);
+ *     while (true) {
+ *       soft_timer_run();
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef SOFT_TIMER_H
+#define	SOFT_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+
+#ifndef LIBPIC170X_SOFT_TIMER_COUNT
+  //! Number of statically allocated timer slots (at most 255)
+  #define LIBPIC170X_SOFT_TIMER_COUNT 16
+#endif
+
+#ifndef LIBPIC170X_SOFT_TIMER_WHEEL_SIZE
+  //! Number of buckets of the timing wheel (must be a power of two)
+  #define LIBPIC170X_SOFT_TIMER_WHEEL_SIZE 8
+#endif
+
+#if (LIBPIC170X_SOFT_TIMER_WHEEL_SIZE & (LIBPIC170X_SOFT_TIMER_WHEEL_SIZE - 1)) != 0
+  #error "LIBPIC170X_SOFT_TIMER_WHEEL_SIZE must be a power of two"
+#endif
+
+// The library must be built with the same sizes (see freq.h)
+#define soft_timer_init __LIBPIC170X_SIZE_TAG2(soft_timer_init, LIBPIC170X_SOFT_TIMER_COUNT, LIBPIC170X_SOFT_TIMER_WHEEL_SIZE)
+
+//! Marks the end of a bucket list and inactive timers
+#define SOFT_TIMER_NONE 0xFF
+
+//! Returned by soft_timer_next_expiry() if no timer is active
+#define SOFT_TIMER_NO_EXPIRY 0xFFFF
+
+/**
+ * Converts milliseconds into soft timer ticks, rounding up. Intended for
+ * constant arguments, which are converted at compile time.
+ */
+#define SOFT_TIMER_MS_TO_TICKS(ms) \
+    ((uint16_t) (((ms) * 1000ul + TIMER0_PERIOD_US - 1) / TIMER0_PERIOD_US))
+
+/**
+ * Callback that is run from soft_timer_run() when a timer expired.
+ *
+ * @param timer
+ *     Slot number of the expired timer.
+ */
+typedef void (*SoftTimerCallback)(uint8_t timer);
+
+/**
+ * Stops all timers and resets the timing wheel. Must be called before using
+ * any other soft_timer function.
+ */
+void soft_timer_init(void);
+
+/**
+ * Starts (or restarts) a timer.
+ *
+ * @param timer
+ *     Slot number of the timer.
+ * @param delay
+ *     Ticks until the first expiry. Values smaller than 1 are treated as 1.
+ * @param period
+ *     Ticks between subsequent expiries, or 0 for a one-shot timer.
+ * @param callback
+ *     Function that soft_timer_run() calls for every expiry (can be NULL).
+ * @return
+ *     False if timer is not a valid slot number.
+ */
+bool soft_timer_start(uint8_t timer, uint16_t delay, uint16_t period, SoftTimerCallback callback);
+
+/**
+ * Stops a timer. Expiries that have already been flagged but not yet been
+ * processed by soft_timer_run() are discarded.
+ *
+ * @param timer
+ *     Slot number of the timer.
+ */
+void soft_timer_stop(uint8_t timer);
+
+/**
+ * Checks if a timer is active.
+ *
+ * @param timer
+ *     Slot number of the timer.
+ * @return
+ *     True if the timer is waiting for its next expiry.
+ */
+bool soft_timer_is_active(uint8_t timer);
+
+/**
+ * Interrupt handler part. Advances the timing wheel by one tick and flags
+ * expired timers. Must be called once per timer0 interrupt, i.e. whenever
+ * timer0_ih() returns true.
+ */
+void soft_timer_tick(void);
+
+/**
+ * Main loop part. Runs the callbacks of all timers that expired since the
+ * last call. Returns immediately if no timer expired.
+ *
+ * @return
+ *     Number of callbacks that were run.
+ */
+uint8_t soft_timer_run(void);
+
+/**
+ * Returns the number of ticks until the next timer expires. Visits all
+ * timer slots, so this is intended for idle handling (see idle.h) rather
+ * than for the main loop.
+ *
+ * @return
+ *     Ticks until the next expiry, 0 if expired timers are waiting for
+ *     soft_timer_run(), or SOFT_TIMER_NO_EXPIRY if no timer is active.
+ */
+uint16_t soft_timer_next_expiry(void);
+
+/**
+ * Advances the timing wheel by multiple ticks at once, e.g. after timer0 was
+ * halted during SLEEP. Timers that expire within the skipped ticks are
+ * flagged once, periodic timers continue one period after the end of the
+ * skipped interval. Visits all timer slots once, independent of ticks.
+ *
+ * @param ticks
+ *     Number of ticks to advance.
+ */
+void soft_timer_advance(uint16_t ticks);
+
+#endif	/* SOFT_TIMER_H */
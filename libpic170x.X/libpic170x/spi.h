@@ -0,0 +1,172 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file spi.h
+ * \brief SPI master on the MSSP module.
+ * 
+ * The spi library operates the MSSP module of the PIC as SPI master. SCK,
+ * SDO and SDI are routed to any PPS-capable pin given as `PinDef`. Chip
+ * select lines are ordinary outputs that are driven by the application.
+ * 
+ * Transfers are full-duplex: for every byte sent one byte is received.
+ * spi_transfer() blocks until a buffer has been transferred,
+ * spi_transfer_async() streams a buffer from the interrupt handler spi_ih()
+ * while the main loop keeps running and reports the completion through
+ * spi_busy() and an optional callback.
+ * 
+ * The clock divisor is computed at compile time from _XTAL_FREQ with
+ * SPI_CLOCK_CONFIG().
+ * 
+ * Example:
+ * 
+ * \code{.c}
+ *   void interrupt int_handler() {
+ *     spi_ih();
+ *   }
+ * 
+ *   int main() {
+ *     uint8_t cmd[4] = {0x03, 0x00, 0x10, 0x00};    // flash READ 0x001000
+ *     uint8_t data[64];
+ *     // ...
+ *     spi_init(SPI_CLOCK_CONFIG(4000000), SPI_MODE_0, PIN_RC0, PIN_RC2, PIN_RC1);
+ *     pin_set_output(PIN_RC3, false);     // chip select
+ *     spi_transfer(cmd, NULL, 4);
+ *     spi_transfer(NULL, data, 64);
+ *     pin_set_output(PIN_RC3, true);
+ *   }
+ * \endcode
+ */
+
+#ifndef SPI_H
+#define	SPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freq.h"
+#include "io_control.h"
+
+//! Clock idle low, data sampled on the rising edge
+#define SPI_MODE_0 0
+//! Clock idle low, data sampled on the falling edge
+#define SPI_MODE_1 1
+//! Clock idle high, data sampled on the falling edge
+#define SPI_MODE_2 2
+//! Clock idle high, data sampled on the rising edge
+#define SPI_MODE_3 3
+
+//! Byte that is sent by transfers without transmit buffer
+#define SPI_FILL_BYTE 0xFF
+
+// Smallest divisor of Fosc/4 that does not exceed the given clock
+#define __LIBPIC170X_SPI_DIV(hz) ((_XTAL_FREQ + 4ul * (hz) - 1) / (4ul * (hz)))
+
+/**
+ * Clock configuration for spi_init() that results in the fastest SPI clock
+ * that does not exceed hz at _XTAL_FREQ. The high byte holds the SSPM mode
+ * bits, the low byte the SSP1ADD value. Intended for constant arguments.
+ * 
+ * The slowest clock is _XTAL_FREQ / 1024, slower requests are clamped.
+ */
+#define SPI_CLOCK_CONFIG(hz) ((uint16_t) ( \
+    (__LIBPIC170X_SPI_DIV(hz) <= 1) ? 0x0000 : \
+    (__LIBPIC170X_SPI_DIV(hz) <= 4) ? 0x0100 : \
+    (__LIBPIC170X_SPI_DIV(hz) <= 256) ? (0x0A00 | (__LIBPIC170X_SPI_DIV(hz) - 1)) : \
+    0x0AFF))
+
+/**
+ * Completion callback of spi_transfer_async(). Runs in the interrupt
+ * handler.
+ */
+typedef void (*SpiCallback)(void);
+
+/**
+ * Configures the MSSP as SPI master and routes the SPI signals to the given
+ * pins. PEIE is enabled, GIE must be enabled by the caller for asynchronous
+ * transfers. The PPS registers must not be locked.
+ * 
+ * @param clock_config
+ *     Clock configuration, see SPI_CLOCK_CONFIG().
+ * @param mode
+ *     One of SPI_MODE_0 to SPI_MODE_3.
+ * @param sck
+ *     Clock output pin.
+ * @param sdo
+ *     Data output pin, or NULL if only receiving.
+ * @param sdi
+ *     Data input pin, or NULL if only transmitting.
+ */
+void spi_init(uint16_t clock_config, uint8_t mode, const PinDef* sck, const PinDef* sdo, const PinDef* sdi);
+
+/**
+ * Sends and receives a single byte. Blocks until the byte was transferred.
+ * Must not be called while an asynchronous transfer is running.
+ * 
+ * @param value
+ *     Byte to send.
+ * @return
+ *     Byte that was received.
+ */
+uint8_t spi_transfer_byte(uint8_t value);
+
+/**
+ * Transfers a buffer. Blocks until all bytes were transferred. Must not be
+ * called while an asynchronous transfer is running.
+ * 
+ * @param tx
+ *     Bytes to send, or NULL to send SPI_FILL_BYTE.
+ * @param rx
+ *     Buffer for the received bytes, or NULL to discard them. May be the
+ *     same as tx.
+ * @param length
+ *     Number of bytes to transfer.
+ */
+void spi_transfer(const uint8_t* tx, uint8_t* rx, uint16_t length);
+
+/**
+ * Starts an interrupt-driven transfer of a buffer and returns immediately.
+ * Both buffers must stay valid until the transfer completed.
+ * 
+ * @param tx
+ *     Bytes to send, or NULL to send SPI_FILL_BYTE.
+ * @param rx
+ *     Buffer for the received bytes, or NULL to discard them. May be the
+ *     same as tx.
+ * @param length
+ *     Number of bytes to transfer.
+ * @param callback
+ *     Function that is called from spi_ih() when the transfer completed
+ *     (can be NULL).
+ * @return
+ *     False if another transfer is still running.
+ */
+bool spi_transfer_async(const uint8_t* tx, uint8_t* rx, uint16_t length, SpiCallback callback);
+
+/**
+ * Checks if an asynchronous transfer is running.
+ */
+bool spi_busy(void);
+
+/**
+ * Interrupt handler part of asynchronous transfers.
+ */
+void spi_ih(void);
+
+//! Interrupt dispatcher entry (see isr.h)
+#define SPI_ISR_ENTRY (SSP1IE && SSP1IF, spi_ih())
+
+#endif	/* SPI_H */
@@ -0,0 +1,259 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file task.h
+ * \brief Stackless cooperative tasks (protothreads).
+ *
+ * The task library allows writing sequential code that waits, e.g. for a
+ * time or a pin level, without blocking the main loop. A task is a
+ * function whose body is wrapped in TASK_BEGIN() and TASK_END(). The wait
+ * macros return from the function and store where to continue in the
+ * task's Task structure. The next call jumps right back to that point
+ * through a switch statement.
+ *
+ * No stack is saved, so a task costs 6 bytes of RAM (Task) and a waiting
+ * task costs one call and one switch per round. Tasks never use more
+ * levels of the hardware stack than ordinary functions. The price is that
+ * local variables are not preserved across waits: keep such state in
+ * static variables or in a structure next to the Task. Resume points are
+ * identified by their line number, so a task body can contain at most one
+ * wait per source line, and it must not wait from within a switch
+ * statement of its own.
+ *
+ * Example:
+ *
+ * \code{.c}
+ *   uint8_t blink(Task* task) {
+ *     TASK_BEGIN(task);
+ *     while (true) {
+ *       PIN_SET_OUTPUT(RC0, true);
+ *       TASK_SLEEP_MS(task, 100);
+ *       PIN_SET_OUTPUT(RC0, false);
+ *       TASK_SLEEP_MS(task, 900);
+ *     }
+ *     TASK_END(task);
+ *   }
+ *
+ *   uint8_t button(Task* task) {
+ *     TASK_BEGIN(task);
+ *     while (true) {
+ *       TASK_WAIT_PIN(task, PIN_RA2, false);
+ *       handle_press();
+ *       TASK_WAIT_PIN(task, PIN_RA2, true);
+ *     }
+ *     TASK_END(task);
+ *   }
+ *
+ *   static TaskSlot tasks[] = { TASK_SLOT(blink), TASK_SLOT(button) };
+ *
+ *   int main() {
+ *     // ...
+ *     timer0_init(NULL);
+ *     GIE = 1;
+ *     while (true) {
+ *       task_run(tasks, sizeof(tasks) / sizeof(tasks[0]));
+ *     }
+ *   }
+ * \endcode
+ */
+
+#ifndef TASK_H
+#define	TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer0.h"
+#include "io_control.h"
+
+//! Returned by a task that waits
+#define TASK_WAITING 0
+//! Returned by a task that finished
+#define TASK_DONE 1
+
+//! Resume point of a task that has not started yet
+#define TASK_RESUME_START 0
+//! Resume point of a finished task
+#define TASK_RESUME_DONE 0xFFFF
+
+/**
+ * \struct Task
+ * State of a task. Initialize with TASK_INIT or task_restart().
+ */
+typedef struct {
+    //! Line of the wait to continue at, or one of the TASK_RESUME_ values
+    uint16_t resume;
+    //! Deadline in ms of TASK_SLEEP_MS() and TASK_WAIT_UNTIL_TIMEOUT()
+    uint32_t deadline;
+} Task;
+
+//! Initializer of a Task that starts at TASK_BEGIN()
+#define TASK_INIT { TASK_RESUME_START, 0 }
+
+/**
+ * Function of a task.
+ *
+ * @param task
+ *     State of the task.
+ * @return
+ *     TASK_WAITING or TASK_DONE.
+ */
+typedef uint8_t (*TaskFunction)(Task* task);
+
+/**
+ * \struct TaskSlot
+ * Task of task_run(), a function with its state.
+ */
+typedef struct {
+    TaskFunction function;
+    Task task;
+} TaskSlot;
+
+//! Initializer of a TaskSlot that runs the given TaskFunction
+#define TASK_SLOT(function) { (function), TASK_INIT }
+
+/**
+ * Starts the body of a task function. Jumps to the wait the task returned
+ * from the last time.
+ */
+#define TASK_BEGIN(task) \
+    switch ((task)->resume) { \
+        case TASK_RESUME_START:
+
+/**
+ * Ends the body of a task function. A task that reaches the end is
+ * finished and returns TASK_DONE on every further call until it is
+ * restarted with task_restart().
+ */
+#define TASK_END(task) \
+    } \
+    (task)->resume = TASK_RESUME_DONE; \
+    return TASK_DONE
+
+/**
+ * Finishes the task early, see TASK_END().
+ */
+#define TASK_EXIT(task) \
+    do { \
+        (task)->resume = TASK_RESUME_DONE; \
+        return TASK_DONE; \
+    } while (0)
+
+/**
+ * Waits until condition is true. The condition is evaluated right away
+ * and once per call of the task function afterwards.
+ */
+#define TASK_WAIT_UNTIL(task, condition) \
+    do { \
+        (task)->resume = __LINE__; \
+        case __LINE__: \
+        if (!(condition)) { \
+            return TASK_WAITING; \
+        } \
+    } while (0)
+
+/**
+ * Waits while condition is true, see TASK_WAIT_UNTIL().
+ */
+#define TASK_WAIT_WHILE(task, condition) TASK_WAIT_UNTIL(task, !(condition))
+
+/**
+ * Returns to the caller once and continues with the next call, so other
+ * tasks can run during long computations.
+ */
+#define TASK_YIELD(task) \
+    do { \
+        (task)->resume = __LINE__; \
+        return TASK_WAITING; \
+        case __LINE__: ; \
+    } while (0)
+
+/**
+ * Waits for the given time in ms, measured with timer0_now(). The
+ * resolution is the timer0 period, see TIMER0_PERIOD_US.
+ */
+#define TASK_SLEEP_MS(task, ms) \
+    do { \
+        (task)->deadline = timer0_now(NULL) + (ms); \
+        TASK_WAIT_UNTIL(task, timer0_deadline_reached(NULL, (task)->deadline)); \
+    } while (0)
+
+/**
+ * Waits until condition is true, but at most the given time in ms. Check
+ * the condition again afterwards to tell the two cases apart.
+ */
+#define TASK_WAIT_UNTIL_TIMEOUT(task, condition, ms) \
+    do { \
+        (task)->deadline = timer0_now(NULL) + (ms); \
+        TASK_WAIT_UNTIL(task, (condition) \
+            || timer0_deadline_reached(NULL, (task)->deadline)); \
+    } while (0)
+
+/**
+ * Waits until the digital input of a pin (PinDef) has the given level.
+ */
+#define TASK_WAIT_PIN(task, pin, level) \
+    TASK_WAIT_UNTIL(task, pin_get_input(pin) == (level))
+
+/**
+ * Waits until the digital input of a pin (PinId) has the given level.
+ */
+#define TASK_WAIT_PIN_ID(task, id, level) \
+    TASK_WAIT_UNTIL(task, pin_id_get_input(id) == (level))
+
+/**
+ * Runs a child task until it is finished, e.g. a driver operation that is
+ * written as a task. The child's Task must be initialized before.
+ *
+ * @param task
+ *     State of the calling task.
+ * @param call
+ *     Call of the child task function, e.g. `read_sensor(&sensor_task)`.
+ */
+#define TASK_WAIT_CHILD(task, call) TASK_WAIT_UNTIL(task, (call) == TASK_DONE)
+
+/**
+ * Resets a task so that it starts at TASK_BEGIN() with its next call.
+ *
+ * @param task
+ *     State of the task.
+ */
+void task_restart(Task* task);
+
+/**
+ * Checks if a task reached TASK_END() or TASK_EXIT().
+ *
+ * @param task
+ *     State of the task.
+ * @return
+ *     True if the task is finished.
+ */
+bool task_is_done(const Task* task);
+
+/**
+ * Calls every task that is not finished once, in order (round robin).
+ *
+ * @param tasks
+ *     Array of tasks.
+ * @param count
+ *     Number of tasks in the array.
+ * @return
+ *     Number of tasks that are not finished.
+ */
+uint8_t task_run(TaskSlot* tasks, uint8_t count);
+
+#endif	/* TASK_H */
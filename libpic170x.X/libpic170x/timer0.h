@@ -24,15 +24,26 @@
  * 
  * The counter requires the function timer0_ih to be called in the PIC's 
  * interrupt handler. The timer0_ih function will take care of updating the
- * counter values according to the used _XTAL_FREQ settings. Please note
- * that this library assumes that the configured frequency of the PIC does
- * not change over time and remains constant while the program runs.
+ * counter values according to the used _XTAL_FREQ settings. If the 
+ * frequency of the PIC is changed while the program runs, this must be done
+ * through clock_set() (see clock.h), which rescales timer0.
  * 
- * The timer is configured with a 256 prescaler, which leads to very
+ * By default the timer is configured with a 256 prescaler, which leads to very
  * high increments of the counter values (for a 8 MHz-configured chip it will
  * be around 32-33 ms). This makes the timer values suitable for rough timing
- * keeping only.
+ * keeping only. The interrupt period can be changed at build time through
+ * `LIBPIC170X_TIMER0_PERIOD_US` (see freq.h).
  * 
+ * The prescaler and the counter increments are derived from _XTAL_FREQ in
+ * the application. timer0_init() and timer0_ih() are defined in this header,
+ * so the interrupt handler uses them as literals. timer0_init() also passes
+ * them to the library, which keeps a copy in pic170x_timer0_clock for the
+ * functions that are not time critical.
+ * 
+ * Reading the 32-bit counter is not atomic on the 8-bit core. Use timer0_now()
+ * to obtain a consistent snapshot without disabling interrupts, and
+ * timer0_elapsed() or timer0_deadline_reached() to compare timestamps in a way
+ * that survives the wraparound of the counter.
  */
 
 #ifndef TIMER0_H
@@ -40,6 +51,11 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+#include <xc.h>
+
+#include "freq.h"
 
 /**
  * \struct Timer0;
@@ -51,11 +67,58 @@ typedef struct {
      * is exhausted */
     uint32_t ms;
     /**
-     * Microsecond porition of the counter. Will always be <= 1000.
+     * Microsecond porition of the counter. Will always be < 1000.
      */
     uint16_t us;
+    /**
+     * Update sequence number. Incremented by timer0_ih() after every counter
+     * update so that readers can detect torn reads.
+     */
+    volatile uint8_t seq;
 } Timer0;
 
+/**
+ * \struct Timer0Clock
+ * Timer0 settings for one processor frequency and interrupt period. The 
+ * values are derived at compile time by freq.h, see TIMER0_CLOCK_INIT.
+ */
+typedef struct {
+    //! Interrupt period in us (TIMER0_PERIOD_US)
+    uint32_t period_us;
+    //! ms portion of the period (TIMER0_MS_INC)
+    uint16_t ms_inc;
+    //! us portion of the period (TIMER0_US_INC)
+    uint16_t us_inc;
+    //! Carry threshold of the us counter (TIMER0_US_CARRY)
+    uint16_t us_carry;
+    //! OPTION_REG bits selecting the prescaler (TIMER0_PRESCALE_BITS)
+    uint8_t prescale_bits;
+    //! TMR0 value at the start of each period (TIMER0_PRELOAD)
+    uint8_t preload;
+    //! Value added to TMR0 on overflow if preload is not 0
+    uint8_t reload;
+    //! log2 of the us per TMR0 increment (TIMER0_TICK_US_SHIFT)
+    uint8_t tick_us_shift;
+} Timer0Clock;
+
+//! Timer0Clock initializer for the configured _XTAL_FREQ and timer0 period
+#define TIMER0_CLOCK_INIT { \
+    TIMER0_PERIOD_US, \
+    TIMER0_MS_INC, \
+    TIMER0_US_INC, \
+    TIMER0_US_CARRY, \
+    TIMER0_PRESCALE_BITS, \
+    TIMER0_PRELOAD, \
+    (uint8_t) (TIMER0_PRELOAD + __LIBPIC170X_TIMER0_RELOAD_COMPENSATION), \
+    TIMER0_TICK_US_SHIFT }
+
+/**
+ * Wraparound-safe comparison of two millisecond timestamps. Evaluates to true
+ * if timestamp a lies before timestamp b. Valid as long as both timestamps
+ * are less than 2^31 ms (~24.8 days) apart.
+ */
+#define TIMER0_TIME_BEFORE(a, b) ((int32_t) ((uint32_t) (a) - (uint32_t) (b)) < 0)
+
 /**
  * Internal default pic170x_timer0 structure that will be used by the functions
  * timer0_init() and timer0_ih() if no alternative is specified.
@@ -63,7 +126,18 @@ typedef struct {
 extern Timer0 pic170x_timer0;
 
 /**
- * Initializes timer0 and the given timer0 structure. This function 
+ * Settings of the library functions that depend on the timer0 period, e.g.
+ * timer0_now_us() and clock_set(). Written by timer0_init_clock(). 
+ * timer0_ih() uses the compile-time values instead.
+ */
+extern Timer0Clock pic170x_timer0_clock;
+
+// Link-time chip check, see libpic170x_check_library_build_arguments()
+#define timer0_init_clock __LIBPIC170X_CHIP_TAG(timer0_init_clock)
+
+/**
+ * Initializes timer0 with the given settings. Use timer0_init() instead, 
+ * which passes the settings for the configured _XTAL_FREQ. This function
  * reconfigures the PIC registers:
  * 
  * - TMR0CS
@@ -75,22 +149,182 @@ extern Timer0 pic170x_timer0;
  *     
  * The timer0 structure that should be initialized. If NULL, it will default
  * to use the pic170x_timer0.
+ * 
+ * @param clock
+ *     Settings that are copied to pic170x_timer0_clock.
  */
-void timer0_init(Timer0 *timer0);
+void timer0_init_clock(Timer0 *timer0, const Timer0Clock* clock);
+
+#if defined(_XTAL_FREQ) || defined(__LIBPIC170X_DOXYGEN)
+/**
+ * Initializes timer0 and the given timer0 structure for the configured 
+ * _XTAL_FREQ and timer0 period, see timer0_init_clock().
+ * 
+ * @param timer0
+ *     
+ * The timer0 structure that should be initialized. If NULL, it will default
+ * to use the pic170x_timer0.
+ */
+static inline void timer0_init(Timer0 *timer0) {
+    static const Timer0Clock clock = TIMER0_CLOCK_INIT;
+    
+    timer0_init_clock(timer0, &clock);
+}
+#endif
+
+/*
+ * Counter update for a TMR0IF that is set, with the given increments.
+ * 
+ * If TMR0 is reloaded, the preload is added instead of assigned. This keeps
+ * the increments that happened since the overflow, so interrupt latency 
+ * does not accumulate. us is always < 1000, so one update carries at most 
+ * one ms.
+ */
+#define __LIBPIC170X_TIMER0_UPDATE_WITH(timer0, ms_inc, us_inc, us_carry, preload, reload) \
+    do { \
+        if (preload) { \
+            TMR0 += (reload); \
+        } \
+        if ((timer0)->us >= (us_carry)) { \
+            (timer0)->us -= (us_carry); \
+            (timer0)->ms += (ms_inc) + 1; \
+        } else { \
+            (timer0)->us += (us_inc); \
+            (timer0)->ms += (ms_inc); \
+        } \
+        (timer0)->seq++; \
+        TMR0IF = 0; \
+    } while (0)
+
+#if defined(_XTAL_FREQ) || defined(__LIBPIC170X_DOXYGEN)
+/*
+ * Counter update of timer0_ih() and TIMER0_ISR_ENTRY. The increments are
+ * compiled in as literals, clock_set() never changes them.
+ */
+#define __LIBPIC170X_TIMER0_UPDATE(timer0) \
+    __LIBPIC170X_TIMER0_UPDATE_WITH(timer0, TIMER0_MS_INC, TIMER0_US_INC, \
+        TIMER0_US_CARRY, TIMER0_PRELOAD, \
+        (uint8_t) (TIMER0_PRELOAD + __LIBPIC170X_TIMER0_RELOAD_COMPENSATION))
+
+/**
+ * Interrupt dispatcher entry (see isr.h). Updates pic170x_timer0 inline and
+ * runs LIBPIC170X_ISR_TIMER0_TICK() afterwards.
+ */
+#define TIMER0_ISR_ENTRY \
+    (TMR0IF, __LIBPIC170X_TIMER0_UPDATE(&pic170x_timer0); LIBPIC170X_ISR_TIMER0_TICK())
 
 /**
  * Interrupt handler. Increment the counter of the given structure as a reaction
  * to a timer0 event. 
  * 
- * The function resets TMR0IF.
+ * The function resets TMR0IF. It is defined in this header, so the 
+ * increments for the configured _XTAL_FREQ and timer0 period are compiled
+ * in as literals. The update only uses additions, one compare and one
+ * subtraction (no division). The [timer0 guide](@ref timer0-guide) gives an
+ * estimate of its cycle count, which is not measured on an XC8 build and
+ * depends on the compiler version and optimization level.
  * 
  * 
  * @param timer0
  * 
  * The structure for which to increment the timer value. If NULL this 
  * defaults to pic170x_timer0.
+ * 
+ * @return
+ *     True if a timer0 overflow was processed. Can be used to drive
+ *     tick-based services like soft_timer_tick().
+ */
+static inline bool timer0_ih(Timer0* timer0) {
+    if (TMR0IF) {
+        if (!timer0) timer0 = &pic170x_timer0;
+        __LIBPIC170X_TIMER0_UPDATE(timer0);
+        return true;
+    }
+    return false;
+}
+#endif
+
+/**
+ * Returns a consistent snapshot of the ms counter without disabling
+ * interrupts. The counter is re-read until no timer0_ih() update happened
+ * during the read, which in practice needs at most one retry.
+ * 
+ * @param timer0
+ * 
+ * The structure to read. If NULL this defaults to pic170x_timer0.
+ * 
+ * @return
+ *     The current value of the ms counter.
+ */
+uint32_t timer0_now(const Timer0* timer0);
+
+/**
+ * Returns a microsecond timestamp by combining the counter with the live
+ * TMR0 register. The resolution is one TMR0 increment (32 us at 32 MHz,
+ * 128 us at 8 MHz, see TIMER0_TICK_US_SHIFT) instead of one timer0 overflow,
+ * while the interrupt rate stays unchanged.
+ * 
+ * An overflow that is pending but has not been processed by timer0_ih() yet
+ * (TMR0IF set, e.g. while GIE is cleared or from within another interrupt
+ * handler) is accounted for. Like timer0_now(), the function does not disable
+ * interrupts.
+ * 
+ * The returned value wraps around every 2^32 us (~71.6 minutes). Compare
+ * timestamps with TIMER0_TIME_BEFORE(), which works for us timestamps that
+ * are less than ~35.8 minutes apart.
+ * 
+ * @param timer0
+ * 
+ * The structure to read. If NULL this defaults to pic170x_timer0.
+ * 
+ * @return
+ *     The current time in microseconds.
+ */
+uint32_t timer0_now_us(const Timer0* timer0);
+
+/**
+ * Advances the counter by the given number of microseconds, e.g. to account
+ * for time in which timer0 was halted during SLEEP (see idle.h). Interrupts
+ * are disabled while the counter is updated.
+ * 
+ * @param timer0
+ * 
+ * The structure to update. If NULL this defaults to pic170x_timer0.
+ * 
+ * @param us
+ *     Microseconds to add to the counter.
+ */
+void timer0_advance(Timer0* timer0, uint32_t us);
+
+/**
+ * Returns the number of milliseconds that passed since the given timestamp.
+ * The result is correct across a wraparound of the counter.
+ * 
+ * @param timer0
+ * 
+ * The structure to read. If NULL this defaults to pic170x_timer0.
+ * 
+ * @param since
+ *     Timestamp previously obtained with timer0_now().
+ * @return
+ *     Elapsed milliseconds.
+ */
+uint32_t timer0_elapsed(const Timer0* timer0, uint32_t since);
+
+/**
+ * Checks if the given deadline has been reached, using wraparound-safe
+ * comparison (see TIMER0_TIME_BEFORE()).
+ * 
+ * @param timer0
+ * 
+ * The structure to read. If NULL this defaults to pic170x_timer0.
+ * 
+ * @param deadline
+ *     Timestamp in ms, e.g. `timer0_now(NULL) + 500`.
+ * @return
+ *     True if the current time is at or after deadline.
  */
-void timer0_ih(Timer0* timer0);
+bool timer0_deadline_reached(const Timer0* timer0, uint32_t deadline);
 
 #endif	/* TIMER0_H */
 
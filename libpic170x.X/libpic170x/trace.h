@@ -0,0 +1,169 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ * \file trace.h
+ * \brief Timestamped event trace for latency and profiling measurements.
+ *
+ * The trace library records events into a static RAM buffer. Every record
+ * holds an event id and a timestamp that combines the live TMR0 register
+ * with pic170x_timer0, so the resolution is one TMR0 increment (see
+ * TIMER0_TICK_US_SHIFT). When the buffer is full, the oldest records are
+ * overwritten, so the buffer always holds the most recent events.
+ *
+ * Probes are placed with TRACE_EVENT(). They only record if
+ * `LIBPIC170X_TRACE` is defined while compiling the application, otherwise
+ * they expand to nothing and cost neither code nor cycles.
+ *
+ * trace_dump() writes the buffer through a callback, e.g. to the EUSART.
+ * The host script `host/trace_decode.py` decodes the dump into event lists
+ * and latency histograms, see the [trace guide](@ref trace-guide).
+ *
+ * Example:
+ *
+ * \code{.c}
+ *   #define EVENT_RX_START 1
+ *   #define EVENT_RX_END 2
+ *
+ *   void interrupt int_handler() {
+ *     TRACE_EVENT(EVENT_RX_START);
+ *     eusart_ih();
+ *     TRACE_EVENT(EVENT_RX_END);
+ *     timer0_ih(NULL);
+ *   }
+ *
+ *   int main() {
+ *     // ...
+ *     timer0_init(NULL);
+ *     trace_init();
+ *     GIE = 1;
+ *     // ...
+ *   }
+ * \endcode
+ */
+
+#ifndef TRACE_H
+#define	TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer0.h"
+
+#ifndef LIBPIC170X_TRACE_SIZE
+  //! Number of records in the trace buffer (power of two, at most 128)
+  #define LIBPIC170X_TRACE_SIZE 16
+#endif
+
+#if (LIBPIC170X_TRACE_SIZE & (LIBPIC170X_TRACE_SIZE - 1)) != 0 || LIBPIC170X_TRACE_SIZE > 128
+  #error "LIBPIC170X_TRACE_SIZE must be a power of two of at most 128"
+#endif
+
+// The library must be built with the same sizes (see freq.h)
+#define trace_init __LIBPIC170X_SIZE_TAG(trace_init, LIBPIC170X_TRACE_SIZE)
+
+//! Largest event id, the upper bit of the id is used by the record format
+#define TRACE_ID_MAX 0x7F
+
+//! Set in TraceRecord.id if a timer0 overflow was pending at the event
+#define TRACE_PENDING 0x80
+
+//! Version of the trace_dump() format, see the trace guide
+#define TRACE_FORMAT_VERSION 1
+
+/**
+ * \struct TraceRecord
+ * One recorded event. The time of the event is pic170x_timer0 at the last
+ * counter update (ms, us) plus the TMR0 increments since then (tmr0).
+ */
+typedef struct {
+    //! Event id, or'ed with TRACE_PENDING
+    uint8_t id;
+    //! Raw TMR0 value
+    uint8_t tmr0;
+    //! Lower 16 bits of pic170x_timer0.ms
+    uint16_t ms;
+    //! pic170x_timer0.us
+    uint16_t us;
+} TraceRecord;
+
+/**
+ * Receives the bytes of trace_dump(). Must not return before the byte has
+ * been accepted.
+ *
+ * @param byte
+ *     Next byte of the dump.
+ */
+typedef void (*TraceWriter)(uint8_t byte);
+
+#if defined(LIBPIC170X_TRACE) || defined(__LIBPIC170X_DOXYGEN)
+  /**
+   * Records an event, see trace_event(). Expands to nothing unless
+   * `LIBPIC170X_TRACE` is defined.
+   */
+  #define TRACE_EVENT(id) trace_event(id)
+#else
+  #define TRACE_EVENT(id) ((void) 0)
+#endif
+
+/**
+ * Clears the trace buffer and starts recording. timer0 should be
+ * initialized before, the timestamps are based on pic170x_timer0.
+ */
+void trace_init(void);
+
+/**
+ * Resumes recording after trace_stop().
+ */
+void trace_start(void);
+
+/**
+ * Stops recording, e.g. to freeze the events that lead to an error. Events
+ * are ignored until trace_start() is called.
+ */
+void trace_stop(void);
+
+/**
+ * Records an event with the current time. Interrupts are disabled for the
+ * few instructions that store the record, so probes can be placed in
+ * interrupt handlers and in the main loop. Use TRACE_EVENT() to place
+ * probes that can be removed at compile time.
+ *
+ * @param id
+ *     Event id, at most TRACE_ID_MAX.
+ */
+void trace_event(uint8_t id);
+
+/**
+ * Returns the number of records in the buffer.
+ *
+ * @return
+ *     Number of records, at most LIBPIC170X_TRACE_SIZE.
+ */
+uint8_t trace_count(void);
+
+/**
+ * Writes the buffer, oldest record first, and removes the written records.
+ * Recording is paused while the records are written, events during the
+ * dump are lost. The dump starts with a header that contains the timer0
+ * settings that the decoder needs, see the [trace guide](@ref trace-guide).
+ *
+ * @param write
+ *     Called for every byte of the dump.
+ */
+void trace_dump(TraceWriter write);
+
+#endif	/* TRACE_H */
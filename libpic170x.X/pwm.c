@@ -0,0 +1,142 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/pwm.h"
+
+#include <xc.h>
+
+static const uint8_t c_output_sources[PWM_CHANNEL_COUNT] = {
+    PIN_OUTPUT_SOURCE_CCP1, PIN_OUTPUT_SOURCE_CCP2, 
+    PIN_OUTPUT_SOURCE_PWM3, PIN_OUTPUT_SOURCE_PWM4
+};
+
+// Duty cycles waiting for pwm_ih(), pending holds one bit per channel
+static uint16_t pending_duty[PWM_CHANNEL_COUNT];
+static volatile uint8_t pending = 0;
+
+static void write_duty(uint8_t channel, uint16_t duty) {
+    uint8_t high = (uint8_t) (duty >> 2);
+    uint8_t low = (uint8_t) (duty & 0x03);
+    
+    switch (channel) {
+        case PWM_CHANNEL_CCP1:
+            CCPR1L = high;
+            CCP1CON = (uint8_t) ((CCP1CON & 0xCF) | (low << 4));
+            break;
+        case PWM_CHANNEL_CCP2:
+            CCPR2L = high;
+            CCP2CON = (uint8_t) ((CCP2CON & 0xCF) | (low << 4));
+            break;
+        case PWM_CHANNEL_PWM3:
+            PWM3DCH = high;
+            PWM3DCL = (uint8_t) (low << 6);
+            break;
+        case PWM_CHANNEL_PWM4:
+            PWM4DCH = high;
+            PWM4DCL = (uint8_t) (low << 6);
+            break;
+    }
+}
+
+void pwm_init(uint16_t config) {
+    T2CON = 0;
+    TMR2IE = 0;
+    pending = 0;
+    PR2 = (uint8_t) config;
+    TMR2 = 0;
+    TMR2IF = 0;
+    T2CON = (uint8_t) (((config >> 8) & 0x03) | 0x04);
+    PEIE = 1;
+}
+
+void pwm_enable(uint8_t channel, const PinDef* pin, uint16_t duty) {
+    if (channel >= PWM_CHANNEL_COUNT) {
+        return;
+    }
+    
+    write_duty(channel, duty);
+    switch (channel) {
+        case PWM_CHANNEL_CCP1:
+            CCP1CON = (uint8_t) ((CCP1CON & 0x30) | 0x0C);
+            break;
+        case PWM_CHANNEL_CCP2:
+            CCP2CON = (uint8_t) ((CCP2CON & 0x30) | 0x0C);
+            break;
+        case PWM_CHANNEL_PWM3:
+            PWM3CON = 0x80;
+            break;
+        case PWM_CHANNEL_PWM4:
+            PWM4CON = 0x80;
+            break;
+    }
+    pin_set_output_source(pin, c_output_sources[channel]);
+    pin_set_pin_mode(pin, true);
+}
+
+void pwm_disable(uint8_t channel, const PinDef* pin) {
+    bool gie;
+    
+    if (channel >= PWM_CHANNEL_COUNT) {
+        return;
+    }
+    
+    pin_set_output_source(pin, PIN_OUTPUT_SOURCE_LATCH);
+    switch (channel) {
+        case PWM_CHANNEL_CCP1: CCP1CON = 0; break;
+        case PWM_CHANNEL_CCP2: CCP2CON = 0; break;
+        case PWM_CHANNEL_PWM3: PWM3CON = 0; break;
+        case PWM_CHANNEL_PWM4: PWM4CON = 0; break;
+    }
+    
+    gie = GIE;
+    GIE = 0;
+    pending &= (uint8_t) ~(1u << channel);
+    if (gie) GIE = 1;
+}
+
+void pwm_set_duty(uint8_t channel, uint16_t duty) {
+    bool gie;
+    
+    if (channel >= PWM_CHANNEL_COUNT) {
+        return;
+    }
+    
+    gie = GIE;
+    GIE = 0;
+    pending_duty[channel] = duty;
+    pending |= (uint8_t) (1u << channel);
+    // Wait for the start of the next period, pwm_ih() disables TMR2IE again
+    TMR2IF = 0;
+    TMR2IE = 1;
+    if (gie) GIE = 1;
+}
+
+void pwm_ih(void) {
+    uint8_t channel;
+    
+    if (!(TMR2IE && TMR2IF)) {
+        return;
+    }
+    TMR2IF = 0;
+    
+    for (channel = 0; channel < PWM_CHANNEL_COUNT; channel++) {
+        if (pending & (1u << channel)) {
+            write_duty(channel, pending_duty[channel]);
+        }
+    }
+    pending = 0;
+    TMR2IE = 0;
+}
@@ -0,0 +1,151 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/ring_buffer.h"
+
+// Records are copied with explicit loops rather than memcpy. Producer and
+// consumer usually run in different interrupt contexts, a shared library
+// function would have to be duplicated by the compiler.
+
+bool ring_buffer_init(RingBuffer* rb, void* storage, uint8_t capacity, uint8_t record_size) {
+    if ((capacity == 0) || (capacity > 128) || (capacity & (capacity - 1))
+            || (record_size == 0)) {
+        return false;
+    }
+    
+    rb->data = (uint8_t*) storage;
+    rb->mask = (uint8_t) (capacity - 1);
+    rb->record_size = record_size;
+    rb->head = 0;
+    rb->tail = 0;
+    return true;
+}
+
+uint8_t ring_buffer_count(const RingBuffer* rb) {
+    return (uint8_t) (rb->head - rb->tail);
+}
+
+uint8_t ring_buffer_space(const RingBuffer* rb) {
+    return (uint8_t) (rb->mask + 1 - (uint8_t) (rb->head - rb->tail));
+}
+
+bool ring_buffer_push(RingBuffer* rb, const void* record) {
+    uint8_t head = rb->head;
+    uint8_t i;
+    uint8_t* dst;
+    const uint8_t* src = (const uint8_t*) record;
+    
+    if ((uint8_t) (head - rb->tail) > rb->mask) {
+        return false;
+    }
+    
+    dst = rb->data + (uint16_t) (head & rb->mask) * rb->record_size;
+    for (i = 0; i < rb->record_size; i++) {
+        dst[i] = src[i];
+    }
+    // Publish the record only after it was written completely
+    rb->head = (uint8_t) (head + 1);
+    return true;
+}
+
+uint8_t ring_buffer_push_bulk(RingBuffer* rb, const void* records, uint8_t count) {
+    uint8_t head = rb->head;
+    uint8_t space = (uint8_t) (rb->mask + 1 - (uint8_t) (head - rb->tail));
+    uint8_t n, i;
+    uint8_t* dst;
+    const uint8_t* src = (const uint8_t*) records;
+    
+    if (count > space) {
+        count = space;
+    }
+    
+    for (n = 0; n < count; n++) {
+        dst = rb->data + (uint16_t) (head & rb->mask) * rb->record_size;
+        for (i = 0; i < rb->record_size; i++) {
+            dst[i] = *src++;
+        }
+        head++;
+    }
+    rb->head = head;
+    return count;
+}
+
+bool ring_buffer_push_byte(RingBuffer* rb, uint8_t value) {
+    uint8_t head = rb->head;
+    
+    if ((uint8_t) (head - rb->tail) > rb->mask) {
+        return false;
+    }
+    rb->data[head & rb->mask] = value;
+    rb->head = (uint8_t) (head + 1);
+    return true;
+}
+
+bool ring_buffer_pop(RingBuffer* rb, void* record) {
+    uint8_t tail = rb->tail;
+    uint8_t i;
+    const uint8_t* src;
+    uint8_t* dst = (uint8_t*) record;
+    
+    if (tail == rb->head) {
+        return false;
+    }
+    
+    src = rb->data + (uint16_t) (tail & rb->mask) * rb->record_size;
+    for (i = 0; i < rb->record_size; i++) {
+        dst[i] = src[i];
+    }
+    // Release the slot only after it was read completely
+    rb->tail = (uint8_t) (tail + 1);
+    return true;
+}
+
+uint8_t ring_buffer_pop_bulk(RingBuffer* rb, void* records, uint8_t count) {
+    uint8_t tail = rb->tail;
+    uint8_t available = (uint8_t) (rb->head - tail);
+    uint8_t n, i;
+    const uint8_t* src;
+    uint8_t* dst = (uint8_t*) records;
+    
+    if (count > available) {
+        count = available;
+    }
+    
+    for (n = 0; n < count; n++) {
+        src = rb->data + (uint16_t) (tail & rb->mask) * rb->record_size;
+        for (i = 0; i < rb->record_size; i++) {
+            *dst++ = src[i];
+        }
+        tail++;
+    }
+    rb->tail = tail;
+    return count;
+}
+
+bool ring_buffer_pop_byte(RingBuffer* rb, uint8_t* value) {
+    uint8_t tail = rb->tail;
+    
+    if (tail == rb->head) {
+        return false;
+    }
+    *value = rb->data[tail & rb->mask];
+    rb->tail = (uint8_t) (tail + 1);
+    return true;
+}
+
+void ring_buffer_clear(RingBuffer* rb) {
+    rb->tail = rb->head;
+}
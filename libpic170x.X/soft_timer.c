@@ -0,0 +1,269 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/soft_timer.h"
+
+#include <xc.h>
+
+#include <string.h>
+
+#define WHEEL_MASK (LIBPIC170X_SOFT_TIMER_WHEEL_SIZE - 1)
+
+typedef struct {
+    //! Links of the bucket list (SOFT_TIMER_NONE terminated)
+    uint8_t next, prev;
+    //! Bucket the timer is stored in, SOFT_TIMER_NONE if inactive
+    uint8_t bucket;
+    //! Remaining wheel revolutions before the timer expires
+    uint16_t rounds;
+    //! Reload value in ticks, 0 for one-shot timers
+    uint16_t period;
+    //! Expiry counter, only written by soft_timer_tick()
+    volatile uint8_t fired;
+    //! Processed expiries, only written by the main loop
+    uint8_t handled;
+    SoftTimerCallback callback;
+} SoftTimerSlot;
+
+static SoftTimerSlot slots[LIBPIC170X_SOFT_TIMER_COUNT];
+static uint8_t buckets[LIBPIC170X_SOFT_TIMER_WHEEL_SIZE];
+static uint8_t cursor;
+
+// Total expiries, lets soft_timer_run() return early if nothing happened
+static volatile uint8_t fired_total;
+static uint8_t handled_total;
+
+static void unlink_slot(uint8_t timer) {
+    SoftTimerSlot* slot = &slots[timer];
+
+    if (slot->prev == SOFT_TIMER_NONE) {
+        buckets[slot->bucket] = slot->next;
+    } else {
+        slots[slot->prev].next = slot->next;
+    }
+    if (slot->next != SOFT_TIMER_NONE) {
+        slots[slot->next].prev = slot->prev;
+    }
+    slot->bucket = SOFT_TIMER_NONE;
+}
+
+static void insert_slot(uint8_t timer, uint16_t delay) {
+    SoftTimerSlot* slot = &slots[timer];
+    uint8_t bucket;
+
+    if (delay < 1) delay = 1;
+
+    // The bucket is first visited ((delay - 1) % WHEEL_SIZE) + 1 ticks from
+    // now, the remaining delay is made up of full revolutions.
+    bucket = (uint8_t) ((cursor + delay) & WHEEL_MASK);
+    slot->rounds = (uint16_t) ((delay - 1) / LIBPIC170X_SOFT_TIMER_WHEEL_SIZE);
+
+    slot->bucket = bucket;
+    slot->prev = SOFT_TIMER_NONE;
+    slot->next = buckets[bucket];
+    if (slot->next != SOFT_TIMER_NONE) {
+        slots[slot->next].prev = timer;
+    }
+    buckets[bucket] = timer;
+}
+
+// Ticks until the given active timer expires
+static uint16_t remaining_ticks(uint8_t timer) {
+    const SoftTimerSlot* slot = &slots[timer];
+
+    return (uint16_t) (((slot->bucket - cursor - 1) & WHEEL_MASK) + 1
+        + slot->rounds * LIBPIC170X_SOFT_TIMER_WHEEL_SIZE);
+}
+
+static void discard_expiries(uint8_t timer) {
+    handled_total += (uint8_t) (slots[timer].fired - slots[timer].handled);
+    slots[timer].handled = slots[timer].fired;
+}
+
+void soft_timer_init(void) {
+    uint8_t i;
+    bool gie = GIE;
+
+    GIE = 0;
+    for (i = 0; i < LIBPIC170X_SOFT_TIMER_COUNT; i++) {
+        slots[i].bucket = SOFT_TIMER_NONE;
+        slots[i].fired = 0;
+        slots[i].handled = 0;
+    }
+    memset(buckets, SOFT_TIMER_NONE, sizeof(buckets));
+    cursor = 0;
+    fired_total = 0;
+    handled_total = 0;
+    if (gie) GIE = 1;
+}
+
+bool soft_timer_start(uint8_t timer, uint16_t delay, uint16_t period, SoftTimerCallback callback) {
+    bool gie;
+
+    if (timer >= LIBPIC170X_SOFT_TIMER_COUNT) {
+        return false;
+    }
+
+    // The wheel is shared with soft_timer_tick(), keep the critical section
+    // to the few instructions that relink the slot.
+    gie = GIE;
+    GIE = 0;
+    if (slots[timer].bucket != SOFT_TIMER_NONE) {
+        unlink_slot(timer);
+    }
+    slots[timer].period = period;
+    slots[timer].callback = callback;
+    discard_expiries(timer);
+    insert_slot(timer, delay);
+    if (gie) GIE = 1;
+
+    return true;
+}
+
+void soft_timer_stop(uint8_t timer) {
+    bool gie;
+
+    if (timer >= LIBPIC170X_SOFT_TIMER_COUNT) {
+        return;
+    }
+
+    gie = GIE;
+    GIE = 0;
+    if (slots[timer].bucket != SOFT_TIMER_NONE) {
+        unlink_slot(timer);
+    }
+    discard_expiries(timer);
+    if (gie) GIE = 1;
+}
+
+bool soft_timer_is_active(uint8_t timer) {
+    return (timer < LIBPIC170X_SOFT_TIMER_COUNT)
+        && (slots[timer].bucket != SOFT_TIMER_NONE);
+}
+
+void soft_timer_tick(void) {
+    uint8_t timer, next;
+
+    cursor = (uint8_t) ((cursor + 1) & WHEEL_MASK);
+
+    for (timer = buckets[cursor]; timer != SOFT_TIMER_NONE; timer = next) {
+        SoftTimerSlot* slot = &slots[timer];
+        next = slot->next;
+
+        if (slot->rounds) {
+            slot->rounds--;
+            continue;
+        }
+
+        slot->fired++;
+        fired_total++;
+        unlink_slot(timer);
+        if (slot->period) {
+            // Reinserting at the head of a bucket never affects the
+            // remaining iteration of the current bucket.
+            insert_slot(timer, slot->period);
+        }
+    }
+}
+
+uint8_t soft_timer_run(void) {
+    uint8_t timer, count = 0;
+
+    if (fired_total == handled_total) {
+        return 0;
+    }
+
+    for (timer = 0; timer < LIBPIC170X_SOFT_TIMER_COUNT; timer++) {
+        SoftTimerSlot* slot = &slots[timer];
+
+        // fired is only incremented by the interrupt handler and handled
+        // only by the main loop, so no interrupt masking is required here.
+        while (slot->handled != slot->fired) {
+            slot->handled++;
+            handled_total++;
+            count++;
+            if (slot->callback) {
+                slot->callback(timer);
+            }
+        }
+    }
+
+    return count;
+}
+
+uint16_t soft_timer_next_expiry(void) {
+    uint8_t timer;
+    uint16_t next = SOFT_TIMER_NO_EXPIRY, ticks;
+    bool gie;
+
+    if (fired_total != handled_total) {
+        return 0;
+    }
+
+    gie = GIE;
+    GIE = 0;
+    for (timer = 0; timer < LIBPIC170X_SOFT_TIMER_COUNT; timer++) {
+        if (slots[timer].bucket == SOFT_TIMER_NONE) {
+            continue;
+        }
+        ticks = remaining_ticks(timer);
+        if (ticks < next) {
+            next = ticks;
+        }
+    }
+    if (gie) GIE = 1;
+
+    return next;
+}
+
+void soft_timer_advance(uint16_t ticks) {
+    uint8_t timer;
+    uint8_t old_cursor = cursor;
+    uint16_t remaining;
+    bool gie;
+
+    if (ticks == 0) {
+        return;
+    }
+
+    gie = GIE;
+    GIE = 0;
+    for (timer = 0; timer < LIBPIC170X_SOFT_TIMER_COUNT; timer++) {
+        SoftTimerSlot* slot = &slots[timer];
+
+        if (slot->bucket == SOFT_TIMER_NONE) {
+            continue;
+        }
+
+        // Relink the timer relative to the advanced wheel position
+        cursor = old_cursor;
+        remaining = remaining_ticks(timer);
+        unlink_slot(timer);
+        cursor = (uint8_t) ((old_cursor + ticks) & WHEEL_MASK);
+
+        if (remaining > ticks) {
+            insert_slot(timer, remaining - ticks);
+        } else {
+            slot->fired++;
+            fired_total++;
+            if (slot->period) {
+                insert_slot(timer, slot->period);
+            }
+        }
+    }
+    cursor = (uint8_t) ((old_cursor + ticks) & WHEEL_MASK);
+    if (gie) GIE = 1;
+}
@@ -0,0 +1,128 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/spi.h"
+
+#include <xc.h>
+
+// State of the asynchronous transfer, only touched by spi_ih() while busy
+static const uint8_t* async_tx;
+static uint8_t* async_rx;
+static uint16_t async_remaining;
+static SpiCallback async_callback;
+static volatile bool async_busy = false;
+
+void spi_init(uint16_t clock_config, uint8_t mode, const PinDef* sck, const PinDef* sdo, const PinDef* sdi) {
+    SSP1CON1 = 0;
+    SSP1IE = 0;
+    async_busy = false;
+    
+    // The MSSP reads the clock back through its input PPS in master mode
+    pin_set_output_source(sck, PIN_OUTPUT_SOURCE_SCK_SCL);
+    pin_set_pin_mode(sck, true);
+    if (sck) {
+        SSPCLKPPS = sck->pin_pps;
+    }
+    if (sdo) {
+        pin_set_output_source(sdo, PIN_OUTPUT_SOURCE_SDO);
+        pin_set_pin_mode(sdo, true);
+    }
+    if (sdi) {
+        SSPDATPPS = sdi->pin_pps;
+        pin_set_pin_mode(sdi, false);
+        pin_set_input_mode(sdi, PIN_INPUT_MODE_DIGITAL);
+    }
+    
+    // CKE = 1 shifts data out on the active-to-idle transition (modes 0, 2)
+    SSP1STAT = (mode & 1) ? 0x00 : 0x40;
+    SSP1ADD = (uint8_t) clock_config;
+    SSP1CON1 = (uint8_t) (((clock_config >> 8) & 0x0F) | ((mode & 2) ? 0x10 : 0x00));
+    SSP1CON1bits.SSPEN = 1;
+    
+    SSP1IF = 0;
+    PEIE = 1;
+}
+
+uint8_t spi_transfer_byte(uint8_t value) {
+    SSP1BUF = value;
+    while (!SSP1STATbits.BF);
+    return SSP1BUF;
+}
+
+void spi_transfer(const uint8_t* tx, uint8_t* rx, uint16_t length) {
+    uint8_t value;
+    
+    while (length--) {
+        SSP1BUF = tx ? *tx++ : SPI_FILL_BYTE;
+        while (!SSP1STATbits.BF);
+        value = SSP1BUF;
+        if (rx) {
+            *rx++ = value;
+        }
+    }
+}
+
+bool spi_transfer_async(const uint8_t* tx, uint8_t* rx, uint16_t length, SpiCallback callback) {
+    if (async_busy) {
+        return false;
+    }
+    if (length == 0) {
+        if (callback) {
+            callback();
+        }
+        return true;
+    }
+    
+    async_tx = tx;
+    async_rx = rx;
+    async_remaining = length;
+    async_callback = callback;
+    async_busy = true;
+    
+    SSP1IF = 0;
+    SSP1IE = 1;
+    SSP1BUF = async_tx ? *async_tx++ : SPI_FILL_BYTE;
+    return true;
+}
+
+bool spi_busy(void) {
+    return async_busy;
+}
+
+void spi_ih(void) {
+    uint8_t value;
+    
+    if (!(SSP1IE && SSP1IF)) {
+        return;
+    }
+    SSP1IF = 0;
+    
+    value = SSP1BUF;
+    if (async_rx) {
+        *async_rx++ = value;
+    }
+    
+    if (--async_remaining) {
+        SSP1BUF = async_tx ? *async_tx++ : SPI_FILL_BYTE;
+        return;
+    }
+    
+    SSP1IE = 0;
+    async_busy = false;
+    if (async_callback) {
+        async_callback();
+    }
+}
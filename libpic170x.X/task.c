@@ -0,0 +1,39 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/task.h"
+
+void task_restart(Task* task) {
+    task->resume = TASK_RESUME_START;
+}
+
+bool task_is_done(const Task* task) {
+    return task->resume == TASK_RESUME_DONE;
+}
+
+uint8_t task_run(TaskSlot* tasks, uint8_t count) {
+    uint8_t alive = 0;
+
+    for (; count > 0; count--, tasks++) {
+        if (tasks->task.resume == TASK_RESUME_DONE) {
+            continue;
+        }
+        if (tasks->function(&tasks->task) == TASK_WAITING) {
+            alive++;
+        }
+    }
+    return alive;
+}
@@ -15,39 +15,96 @@
  */
 
 #include "libpic170x/timer0.h"
-#include "libpic170x/freq.h"
 
 #include <xc.h>
 
 Timer0 pic170x_timer0;
+Timer0Clock pic170x_timer0_clock;
 
-void timer0_init(Timer0 *timer0) {
+void timer0_init_clock(Timer0 *timer0, const Timer0Clock* clock) {
     if (!timer0) timer0 = &pic170x_timer0;
     
+    pic170x_timer0_clock = *clock;
+    
     // Enable timer mode
     TMR0CS = 0;
     
-    // Enable prescaler 1:256
-    OPTION_REG = (unsigned char) (OPTION_REG & 0b11010000) | TIMER0_PRESCALE_BITS;
+    // Select the prescaler derived from LIBPIC170X_TIMER0_PERIOD_US
+    OPTION_REG = (unsigned char) (OPTION_REG & 0b11010000) | clock->prescale_bits;
+    TMR0 = clock->preload;
     
     // Enable interrupts
     TMR0IE = 1;
     
     timer0->ms = 0;
     timer0->us = 0;
+    timer0->seq = 0;
+}
+
+uint32_t timer0_now(const Timer0* timer0) {
+    const volatile Timer0* t = timer0 ? timer0 : &pic170x_timer0;
+    uint8_t seq;
+    uint32_t ms;
+    
+    do {
+        seq = t->seq;
+        ms = t->ms;
+    } while (seq != t->seq);
+    
+    return ms;
 }
 
-void timer0_ih(Timer0* timer0) {
-    if (TMR0IF) {
-        if (!timer0) timer0 = &pic170x_timer0;
-        
-#if TIMER0_MS_INC > 0
-        timer0->ms += TIMER0_MS_INC;
-#endif
-        if ((timer0->us += TIMER0_US_INC) > 1000) {
-            timer0->ms += timer0->us / 1000;
-            timer0->us %= 1000;
+uint32_t timer0_now_us(const Timer0* timer0) {
+    const volatile Timer0* t = timer0 ? timer0 : &pic170x_timer0;
+    uint8_t seq, ticks;
+    uint32_t ms, us;
+    bool pending;
+    
+    do {
+        seq = t->seq;
+        ms = t->ms;
+        us = t->us;
+        ticks = (uint8_t) (TMR0 - pic170x_timer0_clock.preload);
+        pending = TMR0IF;
+        if (pending) {
+            // The overflow happened after the counter was last updated. Read
+            // TMR0 again so the ticks belong to the new period, which has
+            // not been reloaded yet.
+            ticks = TMR0;
         }
-        TMR0IF = 0;
+    } while (seq != t->seq);
+    
+    us += (uint32_t) ticks << pic170x_timer0_clock.tick_us_shift;
+    if (pending) {
+        us += pic170x_timer0_clock.period_us;
+    }
+    
+    // ms * 1000 = ms * (1024 - 16 - 8), avoids the software multiplication
+    return (ms << 10) - (ms << 4) - (ms << 3) + us;
+}
+
+void timer0_advance(Timer0* timer0, uint32_t us) {
+    uint32_t ms = us / 1000;
+    uint16_t rest = (uint16_t) (us - ms * 1000);
+    bool gie = GIE;
+    
+    if (!timer0) timer0 = &pic170x_timer0;
+    
+    GIE = 0;
+    timer0->us += rest;
+    if (timer0->us >= 1000) {
+        timer0->us -= 1000;
+        ms++;
     }
+    timer0->ms += ms;
+    timer0->seq++;
+    if (gie) GIE = 1;
+}
+
+uint32_t timer0_elapsed(const Timer0* timer0, uint32_t since) {
+    return timer0_now(timer0) - since;
+}
+
+bool timer0_deadline_reached(const Timer0* timer0, uint32_t deadline) {
+    return !TIMER0_TIME_BEFORE(timer0_now(timer0), deadline);
 }
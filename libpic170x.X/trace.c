@@ -0,0 +1,138 @@
+/*
+   Copyright 2018 Paul Konstantin Gerke
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "libpic170x/trace.h"
+
+#include <xc.h>
+
+#define TRACE_MASK (LIBPIC170X_TRACE_SIZE - 1)
+
+static TraceRecord records[LIBPIC170X_TRACE_SIZE];
+// Index of the next record to write
+static uint8_t head;
+static uint8_t count;
+// Records that were overwritten before they could be dumped
+static uint16_t lost;
+static volatile bool recording;
+
+// Checksum of the dump that is currently written
+static uint8_t checksum;
+
+static void write_byte(TraceWriter write, uint8_t byte) {
+    checksum += byte;
+    write(byte);
+}
+
+static void write_word(TraceWriter write, uint16_t word) {
+    write_byte(write, (uint8_t) word);
+    write_byte(write, (uint8_t) (word >> 8));
+}
+
+void trace_init(void) {
+    bool gie = GIE;
+
+    GIE = 0;
+    head = 0;
+    count = 0;
+    lost = 0;
+    recording = true;
+    if (gie) GIE = 1;
+}
+
+void trace_start(void) {
+    recording = true;
+}
+
+void trace_stop(void) {
+    recording = false;
+}
+
+void trace_event(uint8_t id) {
+    TraceRecord* record;
+    bool gie;
+
+    if (!recording) {
+        return;
+    }
+
+    gie = GIE;
+    GIE = 0;
+    record = &records[head];
+    head = (uint8_t) ((head + 1) & TRACE_MASK);
+    if (count < LIBPIC170X_TRACE_SIZE) {
+        count++;
+    } else {
+        lost++;
+    }
+
+    // Same sampling as timer0_now_us(): if the overflow is pending, TMR0 is
+    // read again so the value belongs to the new period. The decoder
+    // subtracts the preload.
+    record->tmr0 = TMR0;
+    if (TMR0IF) {
+        record->tmr0 = TMR0;
+        id |= TRACE_PENDING;
+    }
+    record->id = id;
+    record->ms = (uint16_t) pic170x_timer0.ms;
+    record->us = pic170x_timer0.us;
+    if (gie) GIE = 1;
+}
+
+uint8_t trace_count(void) {
+    return count;
+}
+
+void trace_dump(TraceWriter write) {
+    const TraceRecord* record;
+    uint8_t index, n;
+    bool was_recording = recording;
+    bool gie;
+
+    // Records are only written by trace_event(), which returns early once
+    // recording is cleared. An event that is being recorded right now
+    // completes with interrupts disabled, so it is done after this section.
+    gie = GIE;
+    GIE = 0;
+    recording = false;
+    if (gie) GIE = 1;
+
+    write('T');
+    write('R');
+    checksum = 0;
+    write_byte(write, TRACE_FORMAT_VERSION);
+    write_byte(write, count);
+    write_word(write, lost);
+    write_word(write, (uint16_t) pic170x_timer0_clock.period_us);
+    write_word(write, (uint16_t) (pic170x_timer0_clock.period_us >> 16));
+    write_byte(write, pic170x_timer0_clock.preload);
+    write_byte(write, pic170x_timer0_clock.tick_us_shift);
+
+    index = (uint8_t) ((head - count) & TRACE_MASK);
+    for (n = count; n > 0; n--) {
+        record = &records[index];
+        write_byte(write, record->id);
+        write_byte(write, record->tmr0);
+        write_word(write, record->ms);
+        write_word(write, record->us);
+        index = (uint8_t) ((index + 1) & TRACE_MASK);
+    }
+    write(checksum);
+
+    count = 0;
+    lost = 0;
+    recording = was_recording;
+}